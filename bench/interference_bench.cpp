@@ -0,0 +1,326 @@
+#include <container_strategy.h>
+#include <cpu_relax.h>
+#include <inline_atomic_container.h>
+#include <latency_stats.h>
+#include <message.h>
+#include <seqlock_container.h>
+#include <shared_data_container.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Tail latency of publish-to-read under noisy-neighbour interference.
+//
+// Every workload runs for every container strategy twice: quietly and with antagonist threads,
+// which model jobs sharing the host. Reported degradation of p99 and p999 shows how robust the
+// strategy is, not only how fast it is on an idle machine.
+//
+// Workloads:
+//   pingpong - one thread publishes a message and waits for the reply from another thread;
+//   mesh     - every thread publishes to its own channel and reads channels of all others.
+// Antagonists:
+//   bandwidth - streams through a large buffer, saturating memory bandwidth;
+//   thrash    - random writes over a buffer larger than LLC, evicting other data;
+//   syscall   - tight loop of syscalls, polluting caches and TLB with kernel entries.
+//
+// Usage: interference_bench [--workload pingpong|mesh|all] [--messages N] [--mesh PEERS]
+//                           [--bandwidth THREADS] [--thrash THREADS] [--syscall THREADS]
+//                           [--buffer-mb MB]
+
+namespace {
+
+struct Options {
+    std::string workload = "all";
+    size_t messages = 20'000;
+    unsigned mesh_peers = std::min(4u, Configuration::number_of_processes);
+    unsigned bandwidth_threads = 1;
+    unsigned thrash_threads = 1;
+    unsigned syscall_threads = 1;
+    size_t buffer_bytes = 64 << 20;
+};
+
+uint64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Spins until `done` returns true. Yields after a while, so the benchmark makes progress when
+// its threads share CPUs with each other or with antagonists.
+template <class Done>
+void SpinUntil(Done done) {
+    for (unsigned spins = 0; !done(); spins++) {
+        if (spins < 10'000) {
+            CpuRelax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Copies the most recent message of the container, the same way as Consumer::ReadMessage
+bool Read(SharedDataContainer& container, int reader_index, Message& out, uint64_t& generation) {
+    if (container.IsEmpty()) {
+        return false;
+    }
+    int handle = container.ReaderLock(reader_index);
+    out = *container.ReaderGetMessage(handle);
+    generation = container.ReaderGetGeneration(handle);
+    container.ReaderUnlock(reader_index, handle);
+    return true;
+}
+
+bool Read(SeqlockContainer& container, int, Message& out, uint64_t& generation) {
+    return container.ReaderRead(out, generation);
+}
+
+bool Read(InlineAtomicContainer& container, int, Message& out, uint64_t& generation) {
+    return container.ReaderRead(out, generation);
+}
+
+class Antagonists {
+public:
+    // Buffers must be at least 1 MiB
+    explicit Antagonists(const Options& options) {
+        for (unsigned i = 0; i < options.bandwidth_threads; i++) {
+            threads_.emplace_back([this, &options]() { StreamBandwidth(options.buffer_bytes); });
+        }
+        for (unsigned i = 0; i < options.thrash_threads; i++) {
+            threads_.emplace_back([this, &options, i]() { ThrashCache(options.buffer_bytes, i); });
+        }
+        for (unsigned i = 0; i < options.syscall_threads; i++) {
+            threads_.emplace_back([this]() { SyscallStorm(); });
+        }
+    }
+
+    ~Antagonists() {
+        stop_ = true;
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+private:
+    static const size_t kChunkBytes = 1 << 20;
+
+    void StreamBandwidth(size_t bytes) {
+        std::vector<char> source(bytes, 1);
+        std::vector<char> destination(bytes);
+        size_t offset = 0;
+        while (!stop_) {
+            memcpy(destination.data() + offset, source.data() + offset, kChunkBytes);
+            offset = offset + 2 * kChunkBytes <= bytes ? offset + kChunkBytes : 0;
+        }
+    }
+
+    void ThrashCache(size_t bytes, unsigned seed) {
+        std::vector<uint64_t> buffer(bytes / sizeof(uint64_t));
+        // xorshift64
+        uint64_t state = 0x9E3779B97F4A7C15ull + seed;
+        while (!stop_) {
+            for (int i = 0; i < 4096; i++) {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                buffer[state % buffer.size()]++;
+            }
+        }
+    }
+
+    void SyscallStorm() {
+        while (!stop_) {
+            syscall(SYS_getppid);
+        }
+    }
+
+    std::atomic<bool> stop_{false};
+    std::vector<std::thread> threads_;
+};
+
+// Latency from publishing a message to reading it by another thread, which waits for it
+template <class Container>
+LatencyStats PingPong(const Options& options) {
+    auto ping = std::make_unique<Container>();
+    auto pong = std::make_unique<Container>();
+    LatencyStats stats(options.messages);
+    std::thread responder([&]() {
+        uint64_t seen = 0;
+        Message msg;
+        uint64_t generation;
+        while (seen < options.messages) {
+            SpinUntil([&]() { return ping->Generation() != seen; });
+            if (!Read(*ping, 0, msg, generation)) {
+                continue;
+            }
+            stats.Add(std::chrono::nanoseconds{NowNs() - msg.val});
+            seen = generation;
+            pong->WriterUpdateMessage(Message{generation});
+        }
+    });
+    for (uint64_t i = 1; i <= options.messages; i++) {
+        ping->WriterUpdateMessage(Message{NowNs()});
+        SpinUntil([&]() { return pong->Generation() == i; });
+    }
+    responder.join();
+    return stats;
+}
+
+// Latency from publishing a message to reading it by every other peer. Peers poll channels, so
+// only the most recent message is read, like in the mesh of processes.
+template <class Container>
+LatencyStats Mesh(const Options& options) {
+    const unsigned peers = options.mesh_peers;
+    const auto publish_period = std::chrono::microseconds{5};
+    std::vector<std::unique_ptr<Container>> channels;
+    std::vector<LatencyStats> peer_stats;
+    for (unsigned i = 0; i < peers; i++) {
+        channels.push_back(std::make_unique<Container>());
+        peer_stats.emplace_back(options.messages * (peers - 1));
+    }
+    std::atomic<unsigned> finished{0};
+
+    std::vector<std::thread> threads;
+    for (unsigned peer = 0; peer < peers; peer++) {
+        threads.emplace_back([&, peer]() {
+            std::vector<uint64_t> seen(peers, 0);
+            size_t published = 0;
+            auto next_publish = std::chrono::steady_clock::now();
+            unsigned idle_spins = 0;
+            Message msg;
+            uint64_t generation;
+            while (published < options.messages || finished < peers) {
+                bool busy = false;
+                auto now = std::chrono::steady_clock::now();
+                if (published < options.messages && now >= next_publish) {
+                    channels[peer]->WriterUpdateMessage(Message{NowNs()});
+                    next_publish = now + publish_period;
+                    if (++published == options.messages) {
+                        finished++;
+                    }
+                    busy = true;
+                }
+                for (unsigned other = 0; other < peers; other++) {
+                    if (other == peer || channels[other]->Generation() == seen[other]) {
+                        continue;
+                    }
+                    if (Read(*channels[other], peer, msg, generation)) {
+                        peer_stats[peer].Add(std::chrono::nanoseconds{NowNs() - msg.val});
+                        seen[other] = generation;
+                        busy = true;
+                    }
+                }
+                if (busy) {
+                    idle_spins = 0;
+                } else if (++idle_spins > 10'000) {
+                    std::this_thread::yield();
+                } else {
+                    CpuRelax();
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    LatencyStats stats(0);
+    for (const LatencyStats& peer : peer_stats) {
+        stats.Append(peer);
+    }
+    return stats;
+}
+
+using Workload = LatencyStats (*)(const Options&);
+
+void Compare(const std::string& workload, ContainerStrategy strategy, const Options& options,
+             Workload run) {
+    std::string label = workload + " " + ContainerStrategyName(strategy);
+    LatencyStats quiet = run(options);
+    LatencyStats noisy(0);
+    {
+        Antagonists antagonists(options);
+        noisy = run(options);
+    }
+    quiet.Print((label + " quiet").c_str());
+    noisy.Print((label + " noisy").c_str());
+    printf("%-40s p99 x%.2f, p999 x%.2f\n", (label + " degradation").c_str(),
+           double(noisy.Percentile(99)) / std::max<int64_t>(quiet.Percentile(99), 1),
+           double(noisy.Percentile(99.9)) / std::max<int64_t>(quiet.Percentile(99.9), 1));
+}
+
+void CompareStrategies(const std::string& workload, const Options& options) {
+    bool pingpong = workload == "pingpong";
+    Compare(workload, ContainerStrategy::BitmaskCas, options,
+            pingpong ? PingPong<SharedDataContainer> : Mesh<SharedDataContainer>);
+    Compare(workload, ContainerStrategy::Seqlock, options,
+            pingpong ? PingPong<SeqlockContainer> : Mesh<SeqlockContainer>);
+    Compare(workload, ContainerStrategy::InlineAtomic, options,
+            pingpong ? PingPong<InlineAtomicContainer> : Mesh<InlineAtomicContainer>);
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string name = argv[i];
+        std::string value = argv[i + 1];
+        if (name == "--workload") {
+            options.workload = value;
+        } else if (name == "--messages") {
+            options.messages = std::stoul(value);
+        } else if (name == "--mesh") {
+            options.mesh_peers = std::stoi(value);
+        } else if (name == "--bandwidth") {
+            options.bandwidth_threads = std::stoi(value);
+        } else if (name == "--thrash") {
+            options.thrash_threads = std::stoi(value);
+        } else if (name == "--syscall") {
+            options.syscall_threads = std::stoi(value);
+        } else if (name == "--buffer-mb") {
+            options.buffer_bytes = std::stoul(value) << 20;
+        } else {
+            return false;
+        }
+    }
+    // Every peer of the mesh reads with its own lock bit, and the container has enough slots only
+    // for readers of other processes
+    return argc % 2 == 1 && options.buffer_bytes >= (1 << 20) && options.mesh_peers >= 2 &&
+           options.mesh_peers <= Configuration::number_of_processes &&
+           (options.workload == "all" || options.workload == "pingpong" ||
+            options.workload == "mesh");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        fprintf(stderr,
+                "Usage: %s [--workload pingpong|mesh|all] [--messages N] [--mesh PEERS]\n"
+                "          [--bandwidth THREADS] [--thrash THREADS] [--syscall THREADS]"
+                " [--buffer-mb MB]\n"
+                "Mesh supports from 2 to %u peers\n",
+                argv[0], Configuration::number_of_processes);
+        return 1;
+    }
+
+    printf("Publish-to-read latency, %zu messages, antagonists: %u bandwidth, %u thrash, "
+           "%u syscall, %zu MiB buffers\n",
+           options.messages, options.bandwidth_threads, options.thrash_threads,
+           options.syscall_threads, options.buffer_bytes >> 20);
+    LatencyStats::PrintHeader("workload and strategy");
+    if (options.workload == "all" || options.workload == "pingpong") {
+        CompareStrategies("pingpong", options);
+    }
+    if (options.workload == "all" || options.workload == "mesh") {
+        CompareStrategies("mesh", options);
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+#ifndef _LATENCY_STATS_H_
+#define _LATENCY_STATS_H_
+
+#include <algorithm>
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+// Latency samples of a benchmark. Memory for samples is reserved up front, so recording doesn't
+// allocate while the benchmark runs.
+class LatencyStats {
+public:
+    explicit LatencyStats(size_t capacity) {
+        samples_.reserve(capacity);
+    }
+
+    void Add(std::chrono::nanoseconds latency) {
+        if (samples_.size() < samples_.capacity()) {
+            samples_.push_back(latency.count());
+        }
+    }
+
+    // Adds samples of another benchmark thread
+    void Append(const LatencyStats& other) {
+        samples_.insert(samples_.end(), other.samples_.begin(), other.samples_.end());
+    }
+
+    size_t Count() const {
+        return samples_.size();
+    }
+
+    double Mean() const {
+        if (samples_.empty()) {
+            return 0;
+        }
+        double sum = 0;
+        for (int64_t sample : samples_) {
+            sum += sample;
+        }
+        return sum / samples_.size();
+    }
+
+    // Percentile from 0 to 100. Sorts samples.
+    int64_t Percentile(double percentile) {
+        if (samples_.empty()) {
+            return 0;
+        }
+        std::sort(samples_.begin(), samples_.end());
+        size_t index = percentile / 100 * (samples_.size() - 1);
+        return samples_[index];
+    }
+
+    // Prints `label mean p50 p99 p999 max` in nanoseconds
+    void Print(const char* label) {
+        double mean = Mean();
+        printf("%-40s %10.1f %10lld %10lld %10lld %10lld\n", label, mean,
+               static_cast<long long>(Percentile(50)), static_cast<long long>(Percentile(99)),
+               static_cast<long long>(Percentile(99.9)), static_cast<long long>(Percentile(100)));
+    }
+
+    static void PrintHeader(const char* label) {
+        printf("%-40s %10s %10s %10s %10s %10s\n", label, "mean ns", "p50 ns", "p99 ns", "p999 ns",
+               "max ns");
+    }
+
+private:
+    std::vector<int64_t> samples_;
+};
+
+#endif
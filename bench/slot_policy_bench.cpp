@@ -0,0 +1,118 @@
+#include <latency_stats.h>
+#include <shared_data_container.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Publish latency of SharedDataContainer with medium payloads under every slot selection policy.
+//
+// Reader threads constantly lock the most recent message, read the whole payload and unlock it,
+// like consumers of other processes. The writer publishes messages with pauses between them,
+// which are the idle time when the next slot can be prefetched.
+//
+// Usage: slot_policy_bench [readers] [iterations]
+// readers - up to (number_of_processes - 1) * reader_threads_per_process, the reader threads of
+// other processes
+
+namespace {
+
+template <size_t Size>
+struct Payload {
+    unsigned char bytes[Size];
+};
+
+// Writer pause between messages
+const auto kIdle = std::chrono::microseconds{2};
+
+template <class Container, size_t Size>
+void Run(const char* label, unsigned readers, size_t iterations, bool prefetch) {
+    using Message = Payload<Size>;
+    // Value initialization zeroes the container, like fresh shared memory
+    auto container = std::make_unique<Container>();
+    auto msg = std::make_unique<Message>();
+    container->WriterUpdateMessage(*msg);
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> sink{0};
+    std::vector<std::thread> threads;
+    for (unsigned r = 0; r < readers; r++) {
+        threads.emplace_back([&, r]() {
+            uint64_t sum = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                int handle = container->ReaderLock(r);
+                const Message* locked = container->ReaderGetMessage(handle);
+                for (size_t i = 0; i < Size; i += 64) {
+                    sum += locked->bytes[i];
+                }
+                container->ReaderUnlock(r, handle);
+            }
+            sink += sum;
+        });
+    }
+
+    LatencyStats stats(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        memset(msg->bytes, int(i), Size);
+        auto start = std::chrono::steady_clock::now();
+        container->WriterUpdateMessage(*msg);
+        stats.Add(std::chrono::steady_clock::now() - start);
+        if (prefetch) {
+            container->WriterPrefetch();
+        }
+        auto idle_end = std::chrono::steady_clock::now() + kIdle;
+        while (std::chrono::steady_clock::now() < idle_end) {
+        }
+    }
+    stop = true;
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    stats.Print(label);
+}
+
+template <size_t Size>
+void RunPolicies(unsigned readers, size_t iterations) {
+    using FirstFree = BasicSharedDataContainer<Payload<Size>, SlotPolicy::FirstFree>;
+    using RecentlyFreed = BasicSharedDataContainer<Payload<Size>, SlotPolicy::RecentlyFreed>;
+    std::string size = std::to_string(Size) + " B";
+    Run<FirstFree, Size>((size + " first-free").c_str(), readers, iterations, false);
+    Run<RecentlyFreed, Size>((size + " recently-freed").c_str(), readers, iterations, false);
+    Run<RecentlyFreed, Size>((size + " recently-freed + prefetch").c_str(), readers, iterations,
+                             true);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    // By default every consumer process has a reader, if there are CPUs for them
+    unsigned spare_cpus = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+    unsigned readers = std::min<unsigned>(Configuration::number_of_processes - 1, spare_cpus);
+    size_t iterations = 100'000;
+    if (argc > 1) {
+        readers = std::stoi(argv[1]);
+    }
+    if (argc > 2) {
+        iterations = std::stoul(argv[2]);
+    }
+    // The container has enough slots only for reader threads of other processes
+    const unsigned max_readers =
+        (Configuration::number_of_processes - 1) * Configuration::reader_threads_per_process;
+    if (readers > max_readers) {
+        fprintf(stderr, "At most %u readers are supported\n", max_readers);
+        return 1;
+    }
+
+    printf("Publish latency, %u reader threads, %zu messages\n", readers, iterations);
+    LatencyStats::PrintHeader("payload and policy");
+    RunPolicies<256>(readers, iterations);
+    RunPolicies<1024>(readers, iterations);
+    RunPolicies<4096>(readers, iterations);
+    return 0;
+}
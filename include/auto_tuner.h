@@ -0,0 +1,175 @@
+#ifndef _AUTO_TUNER_H_
+#define _AUTO_TUNER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+#include <config.h>
+#include <container_strategy.h>
+#include <inline_atomic_container.h>
+#include <message.h>
+#include <seqlock_container.h>
+#include <shared_data_container.h>
+
+// Result of the calibration
+struct TuningReport {
+    // Strategy with the lowest cost
+    ContainerStrategy strategy = ContainerStrategy::Unset;
+    // Nanoseconds per write and read for every strategy of kContainerStrategies
+    uint32_t cost_ns[kContainerStrategiesCount] = {};
+    // Number of concurrent reader threads
+    uint32_t readers = 0;
+};
+
+// Selects container strategy by running short microbenchmarks of all strategies on the actual
+// hardware.
+//
+// Every strategy is measured on a private container in the heap: the calling thread writes
+// messages while reader threads read them, like consumers of other processes would. Number of
+// readers is the number of consumers of a channel, but not more than other available CPUs, because
+// readers competing with the writer for a CPU measure the scheduler instead of the container.
+// Without spare CPUs writes and reads are measured in the same thread.
+//
+// Cost of a strategy is the time of a single write plus the time of a single read.
+// Calibration takes CPUs from other processes, channels use the report cached for the whole
+// machine, see `TuningCache`.
+class AutoTuner {
+public:
+    static TuningReport Calibrate(
+        std::chrono::nanoseconds duration_per_strategy = std::chrono::milliseconds{5}) {
+        TuningReport report;
+        unsigned spare_cpus = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+        report.readers = std::min<unsigned>(Configuration::number_of_processes - 1, spare_cpus);
+
+        // Strategies are measured in interleaved rounds, and the best round of every strategy is
+        // taken. So preemption or a burst of load from other processes doesn't decide the choice.
+        double cost_ns[kContainerStrategiesCount];
+        std::fill(std::begin(cost_ns), std::end(cost_ns), std::numeric_limits<double>::max());
+        for (int round = 0; round < kRounds; round++) {
+            for (int i = 0; i < kContainerStrategiesCount; i++) {
+                cost_ns[i] = std::min(cost_ns[i], Measure(kContainerStrategies[i], report.readers,
+                                                          duration_per_strategy / kRounds));
+            }
+        }
+        for (int i = 0; i < kContainerStrategiesCount; i++) {
+            if (report.strategy == ContainerStrategy::Unset ||
+                cost_ns[i] < cost_ns[Index(report.strategy)]) {
+                report.strategy = kContainerStrategies[i];
+            }
+            // Reported costs are rounded up, so a measured strategy never has zero cost
+            report.cost_ns[i] = std::clamp<double>(std::ceil(cost_ns[i]), 1, UINT32_MAX);
+        }
+        return report;
+    }
+
+    // Index of the strategy in kContainerStrategies
+    static int Index(ContainerStrategy strategy) {
+        return std::find(std::begin(kContainerStrategies), std::end(kContainerStrategies),
+                         strategy) -
+               std::begin(kContainerStrategies);
+    }
+
+private:
+    static constexpr int kRounds = 5;
+
+    static double Measure(ContainerStrategy strategy, unsigned readers,
+                            std::chrono::nanoseconds duration) {
+        switch (strategy) {
+        case ContainerStrategy::BitmaskCas:
+            return Measure<SharedDataContainer>(
+                readers, duration, [](SharedDataContainer& container, int reader_index) {
+                    int handle = container.ReaderLock(reader_index);
+                    Message msg = *container.ReaderGetMessage(handle);
+                    container.ReaderUnlock(reader_index, handle);
+                    return msg.val;
+                });
+        case ContainerStrategy::Seqlock:
+            return Measure<SeqlockContainer>(readers, duration,
+                                             [](SeqlockContainer& container, int) {
+                                                 Message msg;
+                                                 uint64_t generation;
+                                                 return container.ReaderRead(msg, generation)
+                                                            ? msg.val
+                                                            : 0;
+                                             });
+        case ContainerStrategy::InlineAtomic:
+            return Measure<InlineAtomicContainer>(readers, duration,
+                                                  [](InlineAtomicContainer& container, int) {
+                                                      Message msg;
+                                                      uint64_t generation;
+                                                      return container.ReaderRead(msg, generation)
+                                                                 ? msg.val
+                                                                 : 0;
+                                                  });
+        case ContainerStrategy::Unset:
+            break;
+        }
+        return std::numeric_limits<double>::max();
+    }
+
+    // `read` copies the message from the container by reader with the given index
+    template <class Container, class Read>
+    static double Measure(unsigned readers, std::chrono::nanoseconds duration, Read read) {
+        // Value initialization zeroes the container, like fresh shared memory
+        auto container = std::make_unique<Container>();
+        uint64_t value = 0;
+        container->WriterUpdateMessage(Message{++value});
+
+        std::atomic<bool> stop{false};
+        std::vector<uint64_t> reads(readers, 0);
+        std::vector<std::thread> threads;
+        for (unsigned r = 0; r < readers; r++) {
+            threads.emplace_back([&, r]() {
+                uint64_t count = 0;
+                uint64_t sink = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    sink += read(*container, r);
+                    count++;
+                }
+                reads[r] = count;
+                sink_.fetch_add(sink, std::memory_order_relaxed);
+            });
+        }
+
+        // Clock is checked once per batch, so its cost doesn't affect the result
+        static const unsigned kBatch = 64;
+        uint64_t writes = 0;
+        uint64_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::nanoseconds::zero();
+        do {
+            for (unsigned i = 0; i < kBatch; i++) {
+                container->WriterUpdateMessage(Message{++value});
+                if (readers == 0) {
+                    sink += read(*container, 0);
+                }
+            }
+            writes += kBatch;
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed < duration);
+        stop = true;
+        sink_.fetch_add(sink, std::memory_order_relaxed);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        // Without readers every iteration is a write and a read
+        double cost_ns = double(elapsed.count()) / writes;
+        for (unsigned r = 0; r < readers; r++) {
+            cost_ns += double(elapsed.count()) / reads[r] / readers;
+        }
+        return cost_ns;
+    }
+
+    // Values read during measurements are accumulated here, so reads are not optimized out
+    inline static std::atomic<uint64_t> sink_ = 0;
+};
+
+#endif
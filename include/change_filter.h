@@ -0,0 +1,208 @@
+#ifndef _CHANGE_FILTER_H_
+#define _CHANGE_FILTER_H_
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <linux/futex.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <config.h>
+#include <message.h>
+
+// Field of the message checked by the filter
+enum class FilterField : uint32_t {
+    Value,  // Message::val
+};
+
+enum class FilterKind : uint32_t {
+    // Every message matches. This is the behaviour for consumers without filter.
+    Any,
+    // Value becomes greater than threshold. Filter is rearmed when value drops below
+    // threshold - deadband, so a value jittering around the threshold matches only once.
+    Above,
+    // Value becomes less than threshold. Filter is rearmed when value rises above
+    // threshold + deadband.
+    Below,
+    // Value differs from the value of the last matched message at least by deadband
+    Delta,
+};
+
+struct FilterConfig {
+    FilterField field = FilterField::Value;
+    FilterKind kind = FilterKind::Any;
+    double threshold = 0;
+    double deadband = 0;
+};
+
+// Filters which consumers register in the producer's shared memory object.
+//
+// Producer evaluates filters of all consumers on every publish. It sets the dirty bit and wakes
+// the consumer only if the consumer's filter matches the new message. So threshold-style
+// consumers don't have to reread messages which they are not interested in.
+//
+// Consumers are identified by process index.
+//
+// All class members are zero initialized. This allows to skip constructor call
+// when class instance is created in the zero initialized memory.
+class ChangeFilters {
+public:
+    // Registers filter of the consumer. Replaces the previous filter.
+    //
+    // If the consumer is killed while setting the filter, the producer treats every message as
+    // matching until the filter is set again.
+    void ConsumerSetFilter(int consumer_index, const FilterConfig& config) {
+        Record& record = records_[consumer_index];
+        // Sequence is odd while config is written. After a crash it can be already odd.
+        uint32_t writing_seq = record.seq.load(std::memory_order_relaxed) | 1;
+        record.seq.store(writing_seq, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        record.config = config;
+        record.seq.store(writing_seq + 1, std::memory_order_release);
+    }
+
+    // Returns true if a message matching the consumer's filter was published since the last call
+    bool ConsumerTakeDirty(int consumer_index) {
+        uint32_t bit = uint32_t{1} << consumer_index;
+        return dirty_mask_.fetch_and(~bit) & bit;
+    }
+
+    // Clears the state of waits left by the previous run of the consumer.
+    // Must be called before threads of the consumer wait.
+    void ConsumerReset(int consumer_index) {
+        records_[consumer_index].waiters = 0;
+    }
+
+    // Waits until the dirty bit of the consumer is set, but not longer than `timeout`.
+    // Doesn't clear the bit. Returns true if the bit is set.
+    bool ConsumerWaitDirty(int consumer_index, std::chrono::nanoseconds timeout) {
+        uint32_t bit = uint32_t{1} << consumer_index;
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::atomic<uint32_t>& waiters = records_[consumer_index].waiters;
+        waiters.fetch_add(1);
+        uint32_t mask = dirty_mask_;
+        while ((mask & bit) == 0) {
+            auto left = deadline - std::chrono::steady_clock::now();
+            if (left <= std::chrono::nanoseconds::zero()) {
+                break;
+            }
+            timespec ts;
+            ts.tv_sec = std::chrono::duration_cast<std::chrono::seconds>(left).count();
+            ts.tv_nsec = (left - std::chrono::seconds{ts.tv_sec}).count();
+            // Sleeps only if the mask wasn't changed since it was read.
+            // Shared memory is mapped by several processes, so the futex can't be private.
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&dirty_mask_), FUTEX_WAIT, mask, &ts,
+                    nullptr, 0);
+            mask = dirty_mask_;
+        }
+        waiters.fetch_sub(1);
+        return mask & bit;
+    }
+
+    // Returns true if threads of the consumer wait for the dirty bit, or were killed while waiting
+    // and the consumer hasn't restarted yet
+    bool HasWaiters(int consumer_index) const {
+        return records_[consumer_index].waiters != 0;
+    }
+
+    // Evaluates filters of all consumers for the new message, sets dirty bits and wakes
+    // consumers with matched filters
+    void WriterEvaluate(const Message& msg) {
+        uint32_t matched = 0;
+        for (int i = 0; i < int(Configuration::number_of_processes); i++) {
+            if (Evaluate(records_[i], msg)) {
+                matched |= uint32_t{1} << i;
+            }
+        }
+        if (matched == 0) {
+            return;
+        }
+        uint32_t old_mask = dirty_mask_.fetch_or(matched);
+        // Syscall only if a new bit was set for a consumer which sleeps
+        for (uint32_t set = matched & ~old_mask; set != 0; set &= set - 1) {
+            if (records_[__builtin_ctz(set)].waiters != 0) {
+                syscall(SYS_futex, reinterpret_cast<uint32_t*>(&dirty_mask_), FUTEX_WAKE, INT_MAX,
+                        nullptr, nullptr, 0);
+                break;
+            }
+        }
+    }
+
+private:
+    struct Record {
+        // Written by the consumer, seqlock protected
+        std::atomic<uint32_t> seq = 0;
+        FilterConfig config;
+        // State of the filter. Used only by the producer.
+        // Sequence of the config the state belongs to
+        uint32_t applied_seq = 0;
+        bool armed = false;
+        double last_matched = 0;
+        // Number of threads of the consumer waiting on dirty_mask_. Kept per consumer, so a
+        // consumer killed while waiting makes the producer wake only this consumer in vain until
+        // it restarts, see `ConsumerReset`.
+        std::atomic<uint32_t> waiters = 0;
+    };
+
+    static bool Evaluate(Record& record, const Message& msg) {
+        uint32_t seq = record.seq.load(std::memory_order_acquire);
+        if (seq & 1) {
+            // Consumer is setting the filter or was killed while setting it
+            return true;
+        }
+        FilterConfig config = record.config;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (record.seq.load(std::memory_order_relaxed) != seq) {
+            return true;
+        }
+        if (seq != record.applied_seq) {
+            // New filter, first message defines the initial state
+            record.applied_seq = seq;
+            record.armed = true;
+            record.last_matched = NAN;
+        }
+
+        double value = msg.val;
+        switch (config.kind) {
+        case FilterKind::Any:
+            return true;
+        case FilterKind::Above:
+            if (record.armed && value > config.threshold) {
+                record.armed = false;
+                return true;
+            }
+            if (value < config.threshold - config.deadband) {
+                record.armed = true;
+            }
+            return false;
+        case FilterKind::Below:
+            if (record.armed && value < config.threshold) {
+                record.armed = false;
+                return true;
+            }
+            if (value > config.threshold + config.deadband) {
+                record.armed = true;
+            }
+            return false;
+        case FilterKind::Delta:
+            // NaN of the first message after filter change always matches
+            if (!(std::fabs(value - record.last_matched) < config.deadband)) {
+                record.last_matched = value;
+                return true;
+            }
+            return false;
+        }
+        return true;
+    }
+
+    // Bit is set if a message matching the filter of the consumer with corresponding index
+    // was published
+    std::atomic<uint32_t> dirty_mask_ = 0;
+    Record records_[Configuration::number_of_processes];
+};
+
+#endif
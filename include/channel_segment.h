@@ -0,0 +1,62 @@
+#ifndef _CHANNEL_SEGMENT_H_
+#define _CHANNEL_SEGMENT_H_
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+#include <change_filter.h>
+#include <config.h>
+#include <consumer_cursors.h>
+#include <container_strategy.h>
+#include <inline_atomic_container.h>
+#include <message_history.h>
+#include <seqlock_container.h>
+#include <shared_data_container.h>
+
+// Settings of the channel, chosen by the producer. Kept in shared memory, so they survive
+// restarts of the producer and are visible to consumers.
+struct ChannelSettings {
+    // Container with the most recent message
+    std::atomic<ContainerStrategy> strategy = ContainerStrategy::Unset;
+    // Results of the last calibration, which explain the choice of the strategy (see
+    // `AutoTuner`). Nanoseconds per write and read for every strategy of kContainerStrategies.
+    // Zero if the strategy was set explicitly.
+    uint32_t cost_ns[kContainerStrategiesCount] = {};
+    // Number of concurrent reader threads during the calibration
+    uint32_t calibration_readers = 0;
+    // 1 + index of the process which publishes the channel, zero if it is not known.
+    // The process doesn't read the channel it publishes, including derived channels: the container
+    // has lock slots only for reader threads of other processes (see `SharedDataContainer`).
+    std::atomic<int> publisher_id = 0;
+};
+
+// Content of the shared memory object of a single producer.
+//
+// All class members are zero initialized. This allows to skip constructor call
+// when class instance is created in the zero initialized memory.
+struct ChannelSegment {
+    ChannelSettings settings;
+    // The most recent message, only the container of the selected strategy is used
+    SharedDataContainer container;
+    SeqlockContainer seqlock;
+    InlineAtomicContainer inline_atomic;
+    // Recent messages with publish timestamps
+    MessageHistory history;
+    // Filters of consumers, which are interested only in some messages
+    ChangeFilters filters;
+    // Messages already processed by consumers
+    ConsumerCursors cursors;
+};
+
+// Name of the shared memory object of the process with index `process_index`
+inline std::string ChannelName(int process_index) {
+    return Configuration::shared_obj_name_prefix + std::to_string(process_index);
+}
+
+// Name of the shared memory object of a channel with values derived from other channels
+inline std::string DerivedChannelName(const std::string& name) {
+    return Configuration::shared_obj_name_prefix + "_derived_" + name;
+}
+
+#endif
@@ -1,13 +1,41 @@
 #ifndef _CONFIGURATION_H_
 #define _CONFIGURATION_H_
 
+#include <chrono>
 #include <string>
 
 namespace Configuration {
 // PROCESSES_COUNT is passed by cmake
 const unsigned number_of_processes = PROCESSES_COUNT;
 static_assert(number_of_processes <= 31, "supported up to 31 processes");
+// READER_THREADS_PER_PROCESS is passed by cmake
+const unsigned reader_threads_per_process = READER_THREADS_PER_PROCESS;
+static_assert(reader_threads_per_process >= 1, "at least one reader thread is required");
+// Every reader thread of every process has its own lock bit
+const unsigned number_of_readers = number_of_processes * reader_threads_per_process;
+static_assert(number_of_readers <= 63, "supported up to 63 reader threads in all processes");
 const std::string shared_obj_name_prefix = "shared_memory";
+// Number of recent messages every producer keeps with their timestamps
+const unsigned history_length = 64;
+// Queue where all processes report to a single collector
+const std::string fan_in_obj_name = shared_obj_name_prefix + "_fan_in";
+// Log records of all processes
+const std::string log_obj_name = shared_obj_name_prefix + "_log";
+const unsigned log_capacity = 4096;
+// Strings interned by all processes
+const std::string string_table_obj_name = shared_obj_name_prefix + "_strings";
+const unsigned string_table_capacity = 4096;
+const unsigned string_table_bytes = 256 * 1024;
+// Calibration of container strategies, shared by all channels of the machine
+const std::string tuning_obj_name = shared_obj_name_prefix + "_tuning";
+// Consumers read replicas of channels on their NUMA node only if the relay refreshed the replica
+// within this time, otherwise they read the channel
+const std::chrono::milliseconds replica_max_staleness{10};
+// Relay refreshes the replica at least this often even if the channel doesn't change
+const std::chrono::milliseconds replica_refresh_period{2};
+// Consumers check this often that they read the replica of the NUMA node they run on, and attach
+// the replica if its relay has started since the last check
+const std::chrono::milliseconds replica_attach_period{100};
 }  // namespace Configuration
 
 #endif
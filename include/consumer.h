@@ -0,0 +1,427 @@
+#ifndef _CONSUMER_H_
+#define _CONSUMER_H_
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <channel_segment.h>
+#include <config.h>
+#include <container_strategy.h>
+#include <message.h>
+#include <numa.h>
+#include <numa_replica.h>
+#include <reader_thread_index.h>
+#include <shared_segment.h>
+
+namespace bipc = boost::interprocess;
+
+// Consumer can be shared by several threads of the process. Each thread locks messages with its
+// own reader index (see `ReaderThreadIndex`), so threads don't need external synchronization.
+// Every thread can lock only one message at the same time. Message which is still locked when
+// the thread exits is unlocked, so the next thread with the same index starts clean. Several
+// consumers of the same channel in the process don't release each other's locks.
+//
+// Messages can be locked only in channels with BitmaskCas strategy, `ReadMessage` works with every
+// strategy.
+//
+// On machines with several NUMA nodes consumer reads the replica of the channel on its node, if
+// the relay of the node is running (see `ReplicaRelay`). Replica can be a bit behind the channel,
+// but not more than `Configuration::replica_max_staleness`, otherwise the channel is read.
+// Generations returned by the consumer never go back: the replica is read only if it isn't behind
+// the newest generation the consumer has already returned, otherwise the channel is read.
+// Consumer follows the node it runs on: every `Configuration::replica_attach_period` it checks the
+// node and attaches the replica of the node if it wasn't attached yet, e.g. the relay has started
+// after the consumer.
+// Locked messages are always in the channel.
+class Consumer {
+public:
+    // current_process_index - index of current process
+    // producer_index - index of process-producer to read from
+    Consumer(int current_process_index, int producer_index)
+        : Consumer(current_process_index, ChannelName(producer_index)) {
+        producer_process_index = producer_index;
+    }
+
+    // Creates consumer of a channel with shared memory object `sh_name`.
+    // Used for derived channels, which are not bound to process index.
+    // Throws std::runtime_error if the current process publishes the channel.
+    Consumer(int current_process_index, const std::string& sh_name)
+        : sh_name_(sh_name), process_index_(current_process_index) {
+        // Wait until producer creates shared object
+        while (true) {
+            // shared_memory_object and mapped_region throw exceptions, if shared object is not
+            // available.
+            try {
+                shared_mem_obj_ =
+                    bipc::shared_memory_object(bipc::open_only, sh_name.c_str(), bipc::read_write);
+                mem_region_ = bipc::mapped_region(shared_mem_obj_, bipc::read_write);
+                // creation was successful
+                break;
+            } catch (bipc::interprocess_exception& err) {}
+        }
+
+        segment_ptr_ = static_cast<ChannelSegment*>(mem_region_.get_address());
+        if (segment_ptr_->settings.publisher_id == process_index_ + 1) {
+            throw std::runtime_error("Consumer: process can't read the channel it publishes");
+        }
+        shared_data_ptr_ = &segment_ptr_->container;
+        locks_ = std::make_unique<ThreadLocks>(shared_data_ptr_, process_index_);
+
+        // Reset unfinished reads and waits of all threads left by the previous run of the process.
+        // Only the first consumer of the channel in the process does it: other consumers of the
+        // channel can already have locked messages or wait for updates.
+        if (FirstInProcess(sh_name, process_index_)) {
+            shared_data_ptr_->ReaderReset(process_index_);
+            segment_ptr_->filters.ConsumerReset(process_index_);
+        }
+
+        // Replica is attached on the first read
+        replicas_ = std::make_unique<Replicas>();
+        replicas_->automatic = NumaNodes().size() > 1;
+    }
+
+    // Reads the replica of the channel on NUMA node `node` while it is fresh, instead of following
+    // the node the consumer runs on. Useful for pinned processes, which shouldn't check the node
+    // on reads. Returns false if there is no replica, i.e. the relay of the node has never run.
+    bool AttachReplica(int node) {
+        replicas_->automatic = false;
+        return Attach(node);
+    }
+
+    // Reads the replica of the NUMA node the consumer runs on. This is the default on machines with
+    // several NUMA nodes.
+    void FollowNumaNode() {
+        replicas_->next_attach_ns = 0;
+        replicas_->automatic = true;
+    }
+
+    // Reads only the channel
+    void DetachReplica() {
+        replicas_->automatic = false;
+        replicas_->current = nullptr;
+    }
+
+    // Returns true if messages are currently read from the replica
+    bool ReadsReplica() const {
+        const ReplicaSegment* replica = FreshReplica();
+        return replica && !replica->container.IsEmpty() &&
+               replica->container.Generation() >= replicas_->newest_generation;
+    }
+
+    bool HasMessage() const {
+        return Generation() != 0;
+    }
+
+    // Container strategy of the channel, selected by the producer
+    ContainerStrategy Strategy() const {
+        ContainerStrategy strategy = segment_ptr_->settings.strategy;
+        return strategy == ContainerStrategy::Unset ? ContainerStrategy::BitmaskCas : strategy;
+    }
+
+    // Copies the most recent message and its generation. Returns false if there are no messages.
+    bool ReadMessage(Message& out, uint64_t* generation = nullptr) {
+        uint64_t read_generation = 0;
+        const ReplicaSegment* replica = FreshReplica();
+        if (replica && replica->container.ReaderRead(out, read_generation) &&
+            read_generation >= replicas_->newest_generation) {
+            Returned(read_generation);
+            if (generation) {
+                *generation = read_generation;
+            }
+            return true;
+        }
+        bool read = false;
+        switch (Strategy()) {
+        case ContainerStrategy::Seqlock:
+            read = segment_ptr_->seqlock.ReaderRead(out, read_generation);
+            break;
+        case ContainerStrategy::InlineAtomic:
+            read = segment_ptr_->inline_atomic.ReaderRead(out, read_generation);
+            break;
+        default: {
+            int thread_index = ReaderThreadIndex::Get();
+            if (locks_->handles[thread_index] != -1) {
+                throw std::runtime_error("Consumer: attempt to read while a message is locked");
+            }
+            if (shared_data_ptr_->IsEmpty()) {
+                break;
+            }
+            int reader_index = SharedDataContainer::ReaderIndex(process_index_, thread_index);
+            int handle = shared_data_ptr_->ReaderLock(reader_index);
+            out = *shared_data_ptr_->ReaderGetMessage(handle);
+            read_generation = shared_data_ptr_->ReaderGetGeneration(handle);
+            shared_data_ptr_->ReaderUnlock(reader_index, handle);
+            read = true;
+            break;
+        }
+        }
+        if (read) {
+            Returned(read_generation);
+            if (generation) {
+                *generation = read_generation;
+            }
+        }
+        return read;
+    }
+
+    Message* LockMessage() {
+        if (Strategy() != ContainerStrategy::BitmaskCas) {
+            throw std::runtime_error("Consumer: messages of the channel can't be locked");
+        }
+        int thread_index = ReaderThreadIndex::Get();
+        int& handle = locks_->handles[thread_index];
+        if (handle != -1) {
+            throw std::runtime_error("Consumer: attempt to double lock a message");
+        }
+        if (shared_data_ptr_->IsEmpty()) {
+            throw std::runtime_error("Consumer: attempt to lock an empty message");
+        }
+        handle = shared_data_ptr_->ReaderLock(
+            SharedDataContainer::ReaderIndex(process_index_, thread_index));
+        Returned(shared_data_ptr_->ReaderGetGeneration(handle));
+        return shared_data_ptr_->ReaderGetMessage(handle);
+    }
+
+    // Returns generation of the most recent message, zero if there are no messages.
+    // Cheap check that the message was updated, doesn't lock the message.
+    uint64_t Generation() const {
+        const ReplicaSegment* replica = FreshReplica();
+        if (replica && !replica->container.IsEmpty()) {
+            uint64_t generation = replica->container.Generation();
+            if (generation >= replicas_->newest_generation) {
+                Returned(generation);
+                return generation;
+            }
+        }
+        uint64_t generation;
+        switch (Strategy()) {
+        case ContainerStrategy::Seqlock:
+            generation = segment_ptr_->seqlock.Generation();
+            break;
+        case ContainerStrategy::InlineAtomic:
+            generation = segment_ptr_->inline_atomic.Generation();
+            break;
+        default:
+            generation = shared_data_ptr_->Generation();
+            break;
+        }
+        Returned(generation);
+        return generation;
+    }
+
+    // Returns generation of the message locked by the calling thread
+    uint64_t LockedGeneration() const {
+        int handle = locks_->handles[ReaderThreadIndex::Get()];
+        if (handle == -1) {
+            throw std::runtime_error("Consumer: no locked message");
+        }
+        return shared_data_ptr_->ReaderGetGeneration(handle);
+    }
+
+    void UnlockMessage() {
+        int thread_index = ReaderThreadIndex::Get();
+        int& handle = locks_->handles[thread_index];
+        if (handle == -1) {
+            throw std::runtime_error("Consumer: attempt to unlock not locked message");
+        }
+        shared_data_ptr_->ReaderUnlock(
+            SharedDataContainer::ReaderIndex(process_index_, thread_index), handle);
+        handle = -1;
+    }
+
+    // Registers filter in the producer's shared memory object. After that `TakeUpdate` and
+    // `WaitUpdate` report only messages matching the filter.
+    // Filter is kept by the producer after restart of the consumer.
+    void SetFilter(const FilterConfig& config) {
+        segment_ptr_->filters.ConsumerSetFilter(process_index_, config);
+    }
+
+    // Returns true if a message matching the filter was published since the last call.
+    // Without filter every message matches.
+    bool TakeUpdate() {
+        return segment_ptr_->filters.ConsumerTakeDirty(process_index_);
+    }
+
+    // Waits until a message matching the filter is published, but not longer than `timeout`.
+    // Returns true if `TakeUpdate` would return true.
+    bool WaitUpdate(std::chrono::nanoseconds timeout) {
+        return segment_ptr_->filters.ConsumerWaitDirty(process_index_, timeout);
+    }
+
+    // Generation of the last message processed by the consumer process, zero if nothing was
+    // processed. Kept in the producer's shared memory object, so it survives restarts of the
+    // consumer: messages with generation not greater than this were processed before the restart.
+    uint64_t CommittedGeneration() const {
+        return segment_ptr_->cursors.ConsumerCommitted(process_index_);
+    }
+
+    // Marks the message with `generation` and all older messages as processed.
+    // Should be called after the message is processed, so a message isn't lost if the consumer is
+    // killed while processing it.
+    void Commit(uint64_t generation) {
+        segment_ptr_->cursors.ConsumerCommit(process_index_, generation);
+    }
+
+    // Recent messages of the producer with their timestamps
+    const MessageHistory& History() const {
+        return segment_ptr_->history;
+    }
+
+public:
+    int producer_process_index = -1;  // index of process-producer, -1 for derived channels
+
+private:
+    // Messages locked by reader threads of the process. Released when a thread exits.
+    // Kept on the heap, so the listener stays at the same address when the consumer is moved.
+    struct ThreadLocks final : ReaderThreadIndex::ExitListener {
+        ThreadLocks(SharedDataContainer* container, int process_index)
+            : container(container), process_index(process_index) {
+            handles.fill(-1);
+            ReaderThreadIndex::AddExitListener(this);
+        }
+
+        // Messages which are still locked can't be unlocked after the consumer is destroyed
+        ~ThreadLocks() {
+            ReaderThreadIndex::RemoveExitListener(this);
+            for (int thread_index = 0, num = handles.size(); thread_index < num; thread_index++) {
+                if (handles[thread_index] != -1) {
+                    container->ReaderUnlock(
+                        SharedDataContainer::ReaderIndex(process_index, thread_index),
+                        handles[thread_index]);
+                }
+            }
+        }
+
+        void OnThreadExit(int thread_index) override {
+            container->ReaderResetReader(
+                SharedDataContainer::ReaderIndex(process_index, thread_index));
+            handles[thread_index] = -1;
+        }
+
+        SharedDataContainer* container;
+        int process_index;
+        // Handle of the message locked by each reader thread of the process, -1 if nothing is
+        // locked. Every element is accessed only by the thread with the corresponding index.
+        std::array<int, Configuration::reader_threads_per_process> handles;
+    };
+
+    // Returns true for the first consumer of channel `sh_name` created by the process with index
+    // `process_index`
+    static bool FirstInProcess(const std::string& sh_name, int process_index) {
+        static std::mutex mutex;
+        static std::set<std::pair<std::string, int>> channels;
+        std::lock_guard<std::mutex> lock(mutex);
+        return channels.emplace(sh_name, process_index).second;
+    }
+
+    // Replicas of the channel attached by the consumer. Shared by reader threads, kept on the heap
+    // so the consumer can be moved.
+    struct Replicas {
+        // Serializes attaching
+        std::mutex mutex;
+        // Mapped replicas by NUMA node. Replica stays mapped when another one is attached,
+        // because reader threads can still read it.
+        std::map<int, SharedSegment<ReplicaSegment>> segments;
+        // Replica which is read, nullptr if the channel is read
+        std::atomic<const ReplicaSegment*> current{nullptr};
+        std::atomic<int> current_node{-1};
+        // Consumer follows the NUMA node it runs on
+        std::atomic<bool> automatic{false};
+        // Value of steady_clock when the node is checked next time
+        std::atomic<uint64_t> next_attach_ns{0};
+        // The newest generation returned by the consumer. Replica which is behind it is not read,
+        // so the consumer doesn't see older messages after it has seen newer ones.
+        std::atomic<uint64_t> newest_generation{0};
+    };
+
+    // Remembers the generation returned by the consumer
+    void Returned(uint64_t generation) const {
+        std::atomic<uint64_t>& newest = replicas_->newest_generation;
+        uint64_t current = newest.load(std::memory_order_relaxed);
+        while (current < generation &&
+               !newest.compare_exchange_weak(current, generation, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Makes the replica of the node current. Returns false if there is no replica.
+    bool Attach(int node) const {
+        std::lock_guard<std::mutex> lock(replicas_->mutex);
+        auto it = replicas_->segments.find(node);
+        if (it == replicas_->segments.end()) {
+            try {
+                SharedSegment<ReplicaSegment> segment(ReplicaName(sh_name_, node), bipc::open_only);
+                it = replicas_->segments.emplace(node, std::move(segment)).first;
+            } catch (bipc::interprocess_exception& err) {
+                replicas_->current = nullptr;
+                return false;
+            }
+        }
+        replicas_->current_node = node;
+        replicas_->current = &*it->second;
+        return true;
+    }
+
+    // Attaches the replica of the node the consumer runs on, if the node changed or the replica
+    // wasn't attached yet. Checks the node not more often than replica_attach_period.
+    void FollowNode(uint64_t now_ns) const {
+        uint64_t next_ns = replicas_->next_attach_ns.load(std::memory_order_relaxed);
+        uint64_t period_ns =
+            std::chrono::nanoseconds{Configuration::replica_attach_period}.count();
+        // Only one reader thread checks the node
+        if (now_ns < next_ns ||
+            !replicas_->next_attach_ns.compare_exchange_strong(next_ns, now_ns + period_ns)) {
+            return;
+        }
+        int node = CurrentNumaNode();
+        if (node != replicas_->current_node || replicas_->current == nullptr) {
+            Attach(node);
+        }
+    }
+
+    // Returns the replica if it is attached and its relay is running
+    const ReplicaSegment* FreshReplica() const {
+        bool automatic = replicas_->automatic.load(std::memory_order_relaxed);
+        if (!automatic && replicas_->current.load(std::memory_order_relaxed) == nullptr) {
+            return nullptr;
+        }
+        uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+        if (automatic) {
+            FollowNode(now_ns);
+        }
+        const ReplicaSegment* replica = replicas_->current.load(std::memory_order_acquire);
+        if (!replica) {
+            return nullptr;
+        }
+        uint64_t max_staleness_ns =
+            std::chrono::nanoseconds{Configuration::replica_max_staleness}.count();
+        // Refresh time can be a bit later than `now_ns`, it is written by another process
+        if (replica->refreshed_ns.load(std::memory_order_acquire) + max_staleness_ns < now_ns) {
+            return nullptr;
+        }
+        return replica;
+    }
+
+    std::string sh_name_;
+    bipc::shared_memory_object shared_mem_obj_;
+    bipc::mapped_region mem_region_;
+    int process_index_;  // Index of current process
+    ChannelSegment* segment_ptr_ = nullptr;
+    SharedDataContainer* shared_data_ptr_ = nullptr;
+    // Declared after the mapped region, so it is destroyed while the container is still mapped
+    std::unique_ptr<ThreadLocks> locks_;
+    // Replicas of the channel on NUMA nodes
+    std::unique_ptr<Replicas> replicas_;
+};
+
+#endif
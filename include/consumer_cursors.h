@@ -0,0 +1,47 @@
+#ifndef _CONSUMER_CURSORS_H_
+#define _CONSUMER_CURSORS_H_
+
+#include <atomic>
+#include <stdint.h>
+
+#include <config.h>
+
+// Generations of the producer's messages which consumers have already processed, kept in the
+// producer's shared memory object.
+//
+// Consumer commits the generation after it processed the message. The cursor survives restarts
+// of the consumer, so the restarted consumer skips messages it has already processed instead of
+// processing the current message of every producer again.
+//
+// Consumers are identified by process index. Threads of the consumer process share the cursor.
+//
+// All class members are zero initialized. This allows to skip constructor call
+// when class instance is created in the zero initialized memory.
+class ConsumerCursors {
+public:
+    // Generation of the last processed message, zero if nothing was processed
+    uint64_t ConsumerCommitted(int consumer_index) const {
+        return cursors_[consumer_index].generation.load(std::memory_order_acquire);
+    }
+
+    // Marks messages up to `generation` as processed. The cursor never moves back, so threads
+    // committing concurrently don't lose each other's progress.
+    void ConsumerCommit(int consumer_index, uint64_t generation) {
+        std::atomic<uint64_t>& cursor = cursors_[consumer_index].generation;
+        uint64_t committed = cursor.load(std::memory_order_relaxed);
+        while (committed < generation &&
+               !cursor.compare_exchange_weak(committed, generation, std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+        }
+    }
+
+private:
+    // Every cursor has its own cache line, so commits of different consumers don't contend
+    struct alignas(64) Cursor {
+        std::atomic<uint64_t> generation = 0;
+    };
+
+    Cursor cursors_[Configuration::number_of_processes];
+};
+
+#endif
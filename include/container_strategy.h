@@ -0,0 +1,42 @@
+#ifndef _CONTAINER_STRATEGY_H_
+#define _CONTAINER_STRATEGY_H_
+
+#include <iterator>
+#include <stdint.h>
+
+// How the channel keeps its most recent message
+enum class ContainerStrategy : uint32_t {
+    // Channel isn't configured yet, consumers treat it as BitmaskCas
+    Unset,
+    // SharedDataContainer: readers lock slots with bits in per-slot masks. The only strategy which
+    // allows to access the message in place, without copying.
+    BitmaskCas,
+    // SeqlockContainer: readers copy the message and retry if it was being written
+    Seqlock,
+    // InlineAtomicContainer: message is a single atomic word
+    InlineAtomic,
+};
+
+// Strategies which can be selected for a channel
+constexpr ContainerStrategy kContainerStrategies[] = {
+    ContainerStrategy::BitmaskCas,
+    ContainerStrategy::Seqlock,
+    ContainerStrategy::InlineAtomic,
+};
+constexpr int kContainerStrategiesCount = std::size(kContainerStrategies);
+
+inline const char* ContainerStrategyName(ContainerStrategy strategy) {
+    switch (strategy) {
+    case ContainerStrategy::Unset:
+        return "unset";
+    case ContainerStrategy::BitmaskCas:
+        return "bitmask-cas";
+    case ContainerStrategy::Seqlock:
+        return "seqlock";
+    case ContainerStrategy::InlineAtomic:
+        return "inline-atomic";
+    }
+    return "unknown";
+}
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef _CPU_RELAX_H_
+#define _CPU_RELAX_H_
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Busy-wait hint to the CPU, doesn't make syscalls
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef _DERIVED_VIEWS_H_
+#define _DERIVED_VIEWS_H_
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <channel_segment.h>
+#include <consumer.h>
+#include <message.h>
+#include <producer.h>
+
+// Values derived from messages of several channels, maintained incrementally.
+//
+// Views form a graph: input nodes hold the latest values of channels, computed nodes hold
+// functions of other nodes. Every node has a version. Version of input node is the generation of
+// the message it holds, version of computed node increases every time it is recomputed.
+// Computed node remembers versions of its inputs and is recomputed only if some of them changed,
+// so a changed channel recomputes only nodes downstream of it.
+//
+// Node can use only nodes added before it, which keeps the graph acyclic and makes the order of
+// addition a topological order.
+class DerivedViews {
+public:
+    using NodeId = int;
+    // Computes node value from values of its inputs, in the order of inputs
+    using Function = std::function<double(const double* values, int count)>;
+
+    // How message of the input channel is converted to the node value
+    enum class InputFormat {
+        Integer,  // Message::val, channels of processes
+        Double,   // MessageToDouble, derived channels
+    };
+
+    // Adds node with the latest message of the consumer's channel.
+    // The consumer must outlive the views.
+    NodeId AddInput(Consumer& consumer, InputFormat format = InputFormat::Integer) {
+        Node node;
+        node.consumer = &consumer;
+        node.format = format;
+        nodes_.push_back(std::move(node));
+        return nodes_.size() - 1;
+    }
+
+    // Adds node computed by `function` from values of `inputs`
+    NodeId AddNode(const std::vector<NodeId>& inputs, Function function) {
+        Node node;
+        for (NodeId input : inputs) {
+            if (input < 0 || input >= int(nodes_.size())) {
+                throw std::runtime_error("DerivedViews: unknown input node");
+            }
+        }
+        node.inputs = inputs;
+        node.input_versions.resize(inputs.size(), 0);
+        node.input_values.resize(inputs.size(), 0);
+        node.function = std::move(function);
+        nodes_.push_back(std::move(node));
+        return nodes_.size() - 1;
+    }
+
+    // Publishes value of the node to the derived channel every time the node is recomputed.
+    // Values are published as doubles, see `MessageToDouble`.
+    // process_index - index of the current process. Derived channel can be read by every other
+    // process, but not by the process which publishes it: it has the value of the node already.
+    // strategy - container strategy of the derived channel, see `Producer`
+    void Publish(NodeId node, const std::string& name, int process_index,
+                 ContainerStrategy strategy = ContainerStrategy::Unset) {
+        auto producer = std::make_unique<Producer>(DerivedChannelName(name), strategy);
+        producer->SetPublisher(process_index);
+        nodes_.at(node).producer = std::move(producer);
+    }
+
+    // Rereads changed channels and recomputes nodes downstream of them.
+    // Returns number of recomputed nodes.
+    int Update() {
+        int recomputed = 0;
+        for (Node& node : nodes_) {
+            bool changed = node.consumer ? UpdateInput(node) : UpdateComputed(node);
+            if (changed) {
+                recomputed++;
+                if (node.producer) {
+                    node.producer->UpdateMessage(MessageFromDouble(node.value));
+                }
+            }
+        }
+        return recomputed;
+    }
+
+    // Value of the node, zero until all channels it depends on have messages
+    double Value(NodeId node) const {
+        return nodes_.at(node).value;
+    }
+
+    uint64_t Version(NodeId node) const {
+        return nodes_.at(node).version;
+    }
+
+private:
+    struct Node {
+        // Input node reads the channel of the consumer
+        Consumer* consumer = nullptr;
+        InputFormat format = InputFormat::Integer;
+        // Computed node
+        std::vector<NodeId> inputs;
+        // Versions and values of inputs used for the last computation
+        std::vector<uint64_t> input_versions;
+        std::vector<double> input_values;
+        Function function;
+
+        double value = 0;
+        uint64_t version = 0;
+        std::unique_ptr<Producer> producer;
+    };
+
+    bool UpdateInput(Node& node) {
+        // Generation is checked without locking, most of the time channels are unchanged
+        if (node.consumer->Generation() == node.version) {
+            return false;
+        }
+        Message msg;
+        if (!node.consumer->ReadMessage(msg, &node.version)) {
+            return false;
+        }
+        node.value = node.format == InputFormat::Integer ? msg.val : MessageToDouble(msg);
+        return true;
+    }
+
+    bool UpdateComputed(Node& node) {
+        bool changed = false;
+        for (int i = 0, num = node.inputs.size(); i < num; i++) {
+            const Node& input = nodes_[node.inputs[i]];
+            if (input.version == 0) {
+                // Some channel has no messages yet
+                return false;
+            }
+            if (input.version != node.input_versions[i]) {
+                node.input_versions[i] = input.version;
+                node.input_values[i] = input.value;
+                changed = true;
+            }
+        }
+        if (!changed) {
+            return false;
+        }
+        node.value = node.function(node.input_values.data(), node.input_values.size());
+        node.version++;
+        return true;
+    }
+
+    std::vector<Node> nodes_;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef _FAN_IN_H_
+#define _FAN_IN_H_
+
+#include <utility>
+
+#include <config.h>
+#include <message.h>
+#include <mpsc_queue.h>
+#include <shared_segment.h>
+
+// Queue where every process reports messages to a single collector process.
+// Unlike SharedDataContainer, the collector receives every reported message, not only the last.
+using FanInQueue = MpscQueue<Message, 1024>;
+
+class FanInProducer {
+public:
+    FanInProducer(int process_index)
+        : process_index_(process_index), queue_(Configuration::fan_in_obj_name) {
+        // Reset old unfinished reports
+        queue_->WriterReset(process_index_);
+    }
+
+    // Returns false if the collector doesn't keep up and the queue is full
+    bool Report(const Message& msg) {
+        return queue_->TryPush(process_index_, msg);
+    }
+
+private:
+    int process_index_;
+    SharedSegment<FanInQueue> queue_;
+};
+
+// Only one collector can exist at the same time.
+class FanInCollector {
+public:
+    FanInCollector() : queue_(Configuration::fan_in_obj_name) {}
+
+    // Calls `handler(producer_index, msg)` for up to `max_batch` reported messages.
+    template <class Handler>
+    unsigned Drain(Handler&& handler, unsigned max_batch) {
+        return queue_->CollectorDrain(std::forward<Handler>(handler), max_batch);
+    }
+
+private:
+    SharedSegment<FanInQueue> queue_;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef _INLINE_ATOMIC_CONTAINER_H_
+#define _INLINE_ATOMIC_CONTAINER_H_
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+#include <message.h>
+
+// The most recent message stored in a single atomic word.
+// Reads and writes of the message are single atomic operations, which is possible only for
+// 8-byte messages.
+//
+// There are two words for messages with their generations. The writer writes the new message to
+// the word which is not current and then switches the current word by increasing the sequence.
+// A word is overwritten only after the next sequence is published, so the reader which sees the
+// same sequence before and after copying the word has a message with its own generation. If the
+// producer is killed while writing, the current word still has the previous message.
+//
+// All class members are zero initialized. This allows to skip constructor call
+// when class instance is created in the zero initialized memory.
+class InlineAtomicContainer {
+    static_assert(sizeof(Message) == sizeof(uint64_t), "message must fit in a single word");
+
+public:
+    bool IsEmpty() const {
+        return generation_ == 0;
+    }
+
+    // Returns generation of the most recent message, zero for the empty container
+    uint64_t Generation() const {
+        return generation_;
+    }
+
+    // Copies the most recent message and its generation. Returns false for the empty container.
+    bool ReaderRead(Message& out, uint64_t& generation) const {
+        uint64_t seq = seq_.load(std::memory_order_acquire);
+        while (true) {
+            if (seq == 0) {
+                return false;
+            }
+            const Word& word = words_[seq % 2];
+            // Acquire: if the word was already overwritten, the sequence reread below is newer
+            uint64_t value = word.value.load(std::memory_order_acquire);
+            generation = word.generation.load(std::memory_order_acquire);
+            uint64_t current = seq_.load(std::memory_order_acquire);
+            if (current == seq) {
+                memcpy(&out, &value, sizeof(out));
+                return true;
+            }
+            seq = current;
+        }
+    }
+
+    // Returns the most recent message, nullptr for the empty container.
+    // Only the writer can use it, because only the writer changes messages.
+    const Message* WriterCurrentMessage() const {
+        return IsEmpty() ? nullptr : reinterpret_cast<const Message*>(&words_[seq_ % 2].value);
+    }
+
+    void WriterUpdateMessage(const Message& msg, uint64_t generation) {
+        uint64_t value;
+        memcpy(&value, &msg, sizeof(value));
+        uint64_t seq = seq_.load(std::memory_order_relaxed) + 1;
+        Word& word = words_[seq % 2];
+        word.value.store(value, std::memory_order_release);
+        word.generation.store(generation, std::memory_order_release);
+        seq_.store(seq, std::memory_order_release);
+        generation_.store(generation, std::memory_order_release);
+    }
+
+    void WriterUpdateMessage(const Message& msg) {
+        WriterUpdateMessage(msg, generation_ + 1);
+    }
+
+    // Fixes the state after crash during write. The current word is never written, only the
+    // generation could be not updated yet.
+    void WriterReset() {
+        if (seq_ != 0) {
+            generation_ = words_[seq_ % 2].generation.load();
+        }
+    }
+
+private:
+    struct Word {
+        std::atomic<uint64_t> value = 0;
+        std::atomic<uint64_t> generation = 0;
+    };
+    // Number of writes, the current word is words_[seq_ % 2]. Zero for the empty container
+    std::atomic<uint64_t> seq_ = 0;
+    // Generation of the current word, read without the sequence check
+    std::atomic<uint64_t> generation_ = 0;
+    Word words_[2];
+};
+
+#endif
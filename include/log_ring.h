@@ -0,0 +1,206 @@
+#ifndef _LOG_RING_H_
+#define _LOG_RING_H_
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <stdint.h>
+#include <string>
+#include <unistd.h>
+
+#include <config.h>
+#include <container_strategy.h>
+#include <mpsc_queue.h>
+#include <shared_segment.h>
+
+// Events which processes log
+enum class LogEvent : uint32_t {
+    Waiting,    // waiting for other processes
+    Ready,      // all processes started
+    Read,       // read `value` from process `arg`
+    ReadEmpty,  // process `arg` hasn't written anything yet
+    Write,      // wrote `value`
+    // Calibration measured `value` nanoseconds per write and read for strategy `arg`
+    StrategyCost,
+    // Channel uses strategy `arg`, calibrated with `value` concurrent readers
+    Strategy,
+    // Steady state of the real-time mode made `arg` page faults and `value` heap allocations
+    RtViolation,
+};
+
+// Fixed-format binary log record. Text is formatted only by the logger process.
+struct LogRecord {
+    // Number of the record of the process, a gap means lost records
+    uint64_t sequence;
+    uint64_t timestamp_ns;
+    LogEvent event;
+    int32_t arg;
+    uint64_t value;
+};
+
+// Content of the shared memory object of the log.
+//
+// All class members are zero initialized. This allows to skip constructor call
+// when class instance is created in the zero initialized memory.
+struct LogSegment {
+    MpscQueue<LogRecord, Configuration::log_capacity> queue;
+    // Sequence of the next record of every process. Kept in shared memory, so numbering
+    // continues after restart of the process.
+    std::atomic<uint64_t> next_sequence[Configuration::number_of_processes] = {};
+};
+
+// Appends log records of the process to the shared log.
+// Appending doesn't make syscalls, and doesn't wait if the writer is used by a single thread at a
+// time (see `MpscQueue::TryPush`). If the logger doesn't keep up, records are dropped, and the
+// logger reports the gap in sequence numbers.
+class LogWriter {
+public:
+    LogWriter(int process_index, const std::string& sh_name = Configuration::log_obj_name)
+        : process_index_(process_index), segment_(sh_name) {
+        // Records left unfinished by the previous run of the process are skipped
+        segment_->queue.WriterReset(process_index_);
+    }
+
+    void Log(LogEvent event, int32_t arg = 0, uint64_t value = 0) {
+        LogRecord record;
+        record.sequence = segment_->next_sequence[process_index_].fetch_add(1);
+        record.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::steady_clock::now().time_since_epoch())
+                                  .count();
+        record.event = event;
+        record.arg = arg;
+        record.value = value;
+        segment_->queue.TryPush(process_index_, record);
+    }
+
+private:
+    int process_index_;
+    SharedSegment<LogSegment> segment_;
+};
+
+// Drains the shared log and writes formatted records to the file descriptor.
+// Only one logger can exist at the same time.
+//
+// Records are formatted to a large buffer, which is written when it is full or when the log is
+// drained, so there are few write syscalls under load.
+class LogCollector {
+public:
+    explicit LogCollector(int fd, const std::string& sh_name = Configuration::log_obj_name)
+        : fd_(fd), segment_(sh_name) {}
+
+    ~LogCollector() {
+        Flush();
+    }
+
+    // Formats records available in the log. Returns number of formatted records.
+    unsigned Drain() {
+        unsigned drained = segment_->queue.CollectorDrain(
+            [this](int process_index, const LogRecord& record) { Format(process_index, record); },
+            kBatchSize);
+        if (drained < kBatchSize) {
+            // Log is drained, don't keep records in the buffer
+            Flush();
+        }
+        return drained;
+    }
+
+    void Flush() {
+        size_t written = 0;
+        while (written < size_) {
+            ssize_t res = write(fd_, buffer_ + written, size_ - written);
+            if (res <= 0) {
+                break;
+            }
+            written += res;
+        }
+        size_ = 0;
+    }
+
+private:
+    static const unsigned kBatchSize = 256;
+    // Enough for any formatted record
+    static const size_t kMaxRecordSize = 128;
+
+    void Format(int process_index, const LogRecord& record) {
+        if (sizeof(buffer_) - size_ < 2 * kMaxRecordSize) {
+            Flush();
+        }
+        if (seen_[process_index] && record.sequence > next_sequence_[process_index]) {
+            AppendNumber(process_index);
+            Append(": ");
+            AppendNumber(record.sequence - next_sequence_[process_index]);
+            Append(" log records lost\n");
+        }
+        seen_[process_index] = true;
+        next_sequence_[process_index] = record.sequence + 1;
+
+        AppendNumber(process_index);
+        switch (record.event) {
+        case LogEvent::Waiting:
+            Append(": waiting for other processes\n");
+            break;
+        case LogEvent::Ready:
+            Append(": ready\n");
+            break;
+        case LogEvent::Read:
+            Append(": read info from ");
+            AppendNumber(record.arg);
+            Append(": ");
+            AppendNumber(record.value);
+            Append("\n");
+            break;
+        case LogEvent::ReadEmpty:
+            Append(": read info from ");
+            AppendNumber(record.arg);
+            Append(": empty\n");
+            break;
+        case LogEvent::Write:
+            Append(": write ");
+            AppendNumber(record.value);
+            Append("\n");
+            break;
+        case LogEvent::StrategyCost:
+            Append(": calibrated ");
+            Append(ContainerStrategyName(ContainerStrategy(record.arg)));
+            Append(": ");
+            AppendNumber(record.value);
+            Append(" ns per write and read\n");
+            break;
+        case LogEvent::Strategy:
+            Append(": container strategy ");
+            Append(ContainerStrategyName(ContainerStrategy(record.arg)));
+            Append(", calibrated with ");
+            AppendNumber(record.value);
+            Append(" concurrent readers\n");
+            break;
+        case LogEvent::RtViolation:
+            Append(": RT mode violated: ");
+            AppendNumber(record.arg);
+            Append(" page faults, ");
+            AppendNumber(record.value);
+            Append(" heap allocations\n");
+            break;
+        }
+    }
+
+    void Append(const char* str) {
+        while (*str) {
+            buffer_[size_++] = *str++;
+        }
+    }
+
+    template <class Integer>
+    void AppendNumber(Integer value) {
+        size_ = std::to_chars(buffer_ + size_, buffer_ + sizeof(buffer_), value).ptr - buffer_;
+    }
+
+    int fd_;
+    SharedSegment<LogSegment> segment_;
+    // Sequence of the next record expected from every process, known if the process is seen
+    bool seen_[Configuration::number_of_processes] = {};
+    uint64_t next_sequence_[Configuration::number_of_processes] = {};
+    char buffer_[64 * 1024];
+    size_t size_ = 0;
+};
+
+#endif
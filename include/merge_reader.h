@@ -0,0 +1,146 @@
+#ifndef _MERGE_READER_H_
+#define _MERGE_READER_H_
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#include <message_history.h>
+
+// Message of the merged stream
+struct MergedMessage {
+    int producer_index;
+    HistoryEntry entry;
+};
+
+// Merges histories of several producers into a single stream ordered by publish time.
+//
+// Messages of a single producer are already ordered, so the reader does a k-way merge with a heap
+// of producers keyed by the timestamp of their oldest unread message.
+//
+// The oldest message is delivered if either every producer has unread messages, so nothing older
+// can appear, or the message is older than `lateness` and the reader stops waiting for other
+// producers. A message published later than `lateness` after its timestamp can break the order,
+// such messages are delivered as soon as they are seen and counted in `LateCount`.
+//
+// All memory is allocated in the constructor, polling doesn't allocate.
+class MergeReader {
+public:
+    struct Source {
+        int producer_index;
+        const MessageHistory* history;
+    };
+
+    // Reads only messages published after construction. Delivers up to `max_batch` messages
+    // per poll.
+    MergeReader(const std::vector<Source>& sources, std::chrono::nanoseconds lateness,
+                unsigned max_batch)
+        : lateness_ns_(lateness.count()) {
+        if (max_batch == 0) {
+            throw std::runtime_error("MergeReader: batch can't be empty");
+        }
+        for (const Source& source : sources) {
+            streams_.push_back(
+                Stream{source.producer_index, HistoryCursor(*source.history), false, HistoryEntry{}});
+        }
+        heap_.reserve(streams_.size());
+        batch_.reserve(max_batch);
+    }
+
+    // Returns the next batch of messages in timestamp order, the batch is valid until the next
+    // call. `now_ns` is the current value of std::chrono::steady_clock.
+    const std::vector<MergedMessage>& Poll(uint64_t now_ns) {
+        batch_.clear();
+        // Streams are absent in the heap, when all their messages were delivered
+        if (heap_.size() != streams_.size()) {
+            for (int i = 0, num = streams_.size(); i < num; i++) {
+                if (!streams_[i].has_head && Fetch(streams_[i])) {
+                    PushHeap(i);
+                }
+            }
+        }
+
+        uint64_t watermark = now_ns > lateness_ns_ ? now_ns - lateness_ns_ : 0;
+        while (!heap_.empty() && batch_.size() < batch_.capacity()) {
+            Stream& stream = streams_[heap_.front()];
+            bool all_streams_ready = heap_.size() == streams_.size();
+            if (!all_streams_ready && stream.head.timestamp_ns > watermark) {
+                break;
+            }
+            if (stream.head.timestamp_ns < last_timestamp_ns_) {
+                late_count_++;
+            } else {
+                last_timestamp_ns_ = stream.head.timestamp_ns;
+            }
+            batch_.push_back(MergedMessage{stream.producer_index, stream.head});
+
+            int stream_index = heap_.front();
+            std::pop_heap(heap_.begin(), heap_.end(), HeapCompare{this});
+            heap_.pop_back();
+            if (Fetch(stream)) {
+                PushHeap(stream_index);
+            }
+        }
+        return batch_;
+    }
+
+    const std::vector<MergedMessage>& Poll() {
+        return Poll(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+    }
+
+    // Number of messages overwritten in histories before they were read
+    uint64_t LostCount() const {
+        uint64_t lost_count = 0;
+        for (const Stream& stream : streams_) {
+            lost_count += stream.cursor.LostCount();
+        }
+        return lost_count;
+    }
+
+    // Number of messages delivered out of order, because they were published too late
+    uint64_t LateCount() const {
+        return late_count_;
+    }
+
+private:
+    struct Stream {
+        int producer_index;
+        HistoryCursor cursor;
+        // Oldest unread message, valid if `has_head` is set
+        bool has_head = false;
+        HistoryEntry head;
+    };
+
+    // Orders heap by timestamp of the oldest message, std heap keeps the greatest element on top
+    struct HeapCompare {
+        const MergeReader* reader;
+        bool operator()(int lhs, int rhs) const {
+            return reader->streams_[lhs].head.timestamp_ns >
+                   reader->streams_[rhs].head.timestamp_ns;
+        }
+    };
+
+    void PushHeap(int stream_index) {
+        heap_.push_back(stream_index);
+        std::push_heap(heap_.begin(), heap_.end(), HeapCompare{this});
+    }
+
+    // Reads the next message of the stream to its head. Returns false if there is no new message.
+    bool Fetch(Stream& stream) {
+        stream.has_head = stream.cursor.Next(stream.head);
+        return stream.has_head;
+    }
+
+    uint64_t lateness_ns_;
+    std::vector<Stream> streams_;
+    // Indices of streams which have unread messages
+    std::vector<int> heap_;
+    std::vector<MergedMessage> batch_;
+    uint64_t last_timestamp_ns_ = 0;
+    uint64_t late_count_ = 0;
+};
+
+#endif
@@ -2,13 +2,28 @@
 #define _MESSAGE_H_
 
 #include <stdint.h>
+#include <string.h>
+
 // For simplicity use uint64 value as message.
-// If there is a need to determine that the message has not been updated since the last read,
-// then some kind of generation is needed.
+// Containers keep a generation next to the message, so readers can determine that the message
+// has not been updated since the last read.
 struct Message {
     uint64_t val;
     // unsigned length;
     // std::byte data[Configuration::max_message_size];
 };
 
+// Derived channels publish floating point values in the same message
+inline Message MessageFromDouble(double value) {
+    Message msg;
+    memcpy(&msg.val, &value, sizeof(value));
+    return msg;
+}
+
+inline double MessageToDouble(const Message& msg) {
+    double value;
+    memcpy(&value, &msg.val, sizeof(value));
+    return value;
+}
+
 #endif
@@ -0,0 +1,128 @@
+#ifndef _MESSAGE_HISTORY_H_
+#define _MESSAGE_HISTORY_H_
+
+#include <algorithm>
+#include <atomic>
+#include <stdint.h>
+
+#include <config.h>
+#include <message.h>
+
+// Message with the time it was published by the producer and its generation.
+// Generation is a number of the message in the producer's stream starting from 1.
+struct HistoryEntry {
+    uint64_t generation;
+    // Value of std::chrono::steady_clock, which is the same for all processes on Linux
+    uint64_t timestamp_ns;
+    Message message;
+};
+
+// Ring of the most recent messages of a single producer. Unlike SharedDataContainer, readers can
+// see every message if they keep up with the producer.
+//
+// Readers don't lock entries. Producer overwrites the oldest entry, readers detect that the entry
+// was overwritten while copying and report it as lost.
+//
+// All class members are zero initialized. This allows to skip constructor call
+// when class instance is created in the zero initialized memory.
+class MessageHistory {
+public:
+    // Returns generation of the most recent message, zero if there were no messages
+    uint64_t LastGeneration() const {
+        return last_generation_.load(std::memory_order_acquire);
+    }
+
+    // Returns generation of the oldest message which is still in the ring
+    uint64_t FirstGeneration() const {
+        uint64_t last = LastGeneration();
+        return last < std::size(entries_) ? 1 : last - std::size(entries_) + 1;
+    }
+
+    // Copies message with generation `generation` to `out`.
+    // Returns false if the message is not published yet or is already overwritten.
+    bool ReaderGet(uint64_t generation, HistoryEntry& out) const {
+        const Entry& entry = entries_[generation % std::size(entries_)];
+        if (entry.generation.load(std::memory_order_acquire) != generation) {
+            return false;
+        }
+        out.timestamp_ns = entry.timestamp_ns;
+        out.message = entry.message;
+        // Entry could be overwritten while it was copied, check generation again
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.generation.load(std::memory_order_relaxed) != generation) {
+            return false;
+        }
+        out.generation = generation;
+        return true;
+    }
+
+    // Appends a new message. Returns its generation.
+    //
+    // If the producer is killed while writing, the entry stays invalid and is rewritten by the
+    // next message, because `last_generation_` is updated only after the write.
+    uint64_t WriterAppend(uint64_t timestamp_ns, const Message& msg) {
+        uint64_t generation = last_generation_.load(std::memory_order_relaxed) + 1;
+        return WriterAppend(timestamp_ns, msg, generation);
+    }
+
+    // Appends a new message with the given generation, which must be greater than the generation
+    // of the previous message. Used by the producer to keep generations of the history equal to
+    // generations of the container.
+    uint64_t WriterAppend(uint64_t timestamp_ns, const Message& msg, uint64_t generation) {
+        Entry& entry = entries_[generation % std::size(entries_)];
+        // Invalidate the entry for readers before it is overwritten
+        entry.generation.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        entry.timestamp_ns = timestamp_ns;
+        entry.message = msg;
+        entry.generation.store(generation, std::memory_order_release);
+        last_generation_.store(generation, std::memory_order_release);
+        return generation;
+    }
+
+private:
+    struct Entry {
+        // Generation of the message in the entry, zero while the entry is written
+        std::atomic<uint64_t> generation = 0;
+        uint64_t timestamp_ns = 0;
+        Message message;
+    };
+    std::atomic<uint64_t> last_generation_ = 0;
+    Entry entries_[Configuration::history_length];
+};
+
+// Position of a single reader in the producer's history.
+class HistoryCursor {
+public:
+    // Cursor starts after the most recent message
+    explicit HistoryCursor(const MessageHistory& history)
+        : history_(&history), next_generation_(history.LastGeneration() + 1) {}
+
+    // Reads the next unread message to `out`. Returns false if there are no new messages.
+    // Messages overwritten before they were read are skipped and counted in `LostCount`.
+    bool Next(HistoryEntry& out) {
+        while (next_generation_ <= history_->LastGeneration()) {
+            if (history_->ReaderGet(next_generation_, out)) {
+                next_generation_++;
+                return true;
+            }
+            // Message was overwritten, skip to the oldest message in the ring
+            uint64_t first = std::max(history_->FirstGeneration(), next_generation_ + 1);
+            lost_count_ += first - next_generation_;
+            next_generation_ = first;
+        }
+        return false;
+    }
+
+    uint64_t LostCount() const {
+        return lost_count_;
+    }
+
+private:
+    const MessageHistory* history_;
+    // Generation of the next message to read
+    uint64_t next_generation_;
+    uint64_t lost_count_ = 0;
+};
+
+#endif
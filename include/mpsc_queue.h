@@ -0,0 +1,199 @@
+#ifndef _MPSC_QUEUE_H_
+#define _MPSC_QUEUE_H_
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <signal.h>
+#include <type_traits>
+#include <unistd.h>
+
+#include <config.h>
+#include <cpu_relax.h>
+
+// Multi-producer single-consumer queue placed in a single shared memory object.
+//
+// Every process can push values to the queue, a single collector process drains them in FIFO
+// order. Nothing is lost while the collector keeps up: if the queue is full, `TryPush` fails and
+// the producer decides what to do with the value.
+//
+// All class members are zero initialized. This allows to skip constructor call
+// when class instance is created in the zero initialized memory.
+template <class T, unsigned Capacity>
+class MpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    static_assert(Capacity > Configuration::number_of_processes,
+                  "capacity must exceed number of concurrent producers");
+    static_assert(std::is_trivially_copyable_v<T>, "values are copied to shared memory");
+
+public:
+    // Registers the process as producer and fixes the state after crash during push.
+    // Entries left unfinished by the previous run of the process are skipped by the collector.
+    void WriterReset(int producer_index) {
+        producer_pids_[producer_index] = getpid();
+        for (Entry& entry : entries_) {
+            uint64_t state = entry.state;
+            if (Tag(state) == kWriting && Writer(state) == producer_index) {
+                entry.state.compare_exchange_strong(state, MakeState(Lap(state), 0, kAbandoned));
+            }
+        }
+    }
+
+    // Appends value to the queue. Returns false if the queue is full.
+    // Doesn't make syscalls and doesn't wait while every producer index is used by a single
+    // thread at a time.
+    //
+    // Position in the queue is reserved with a single fetch_add. Then the entry is claimed,
+    // written and committed. The producer can be killed at any moment, it doesn't block the
+    // collector forever: see `CollectorDrain`.
+    bool TryPush(int producer_index, const T& value) {
+        while (true) {
+            // Positions are reserved without CAS, so several producers can pass this check
+            // at the same time. Leave room for all of them.
+            // Head is loaded first: it only grows and never passes the tail, so the difference
+            // doesn't wrap around.
+            uint64_t head = head_;
+            uint64_t tail = tail_;
+            if (tail - head + Configuration::number_of_processes > Capacity) {
+                return false;
+            }
+            uint64_t pos = tail_.fetch_add(1);
+            uint64_t lap = pos / Capacity;
+            Entry& entry = entries_[pos % Capacity];
+
+            uint64_t state = entry.state;
+            // Entry can hold a value of the previous lap only if more threads than
+            // number_of_processes passed the fullness check at the same time, e.g. several
+            // threads of a process push with the same producer index. Wait until the collector
+            // frees it.
+            while (Lap(state) < lap) {
+                CpuRelax();
+                state = entry.state;
+            }
+            if (Lap(state) > lap || Tag(state) != kFree) {
+                // The collector decided that reservation is lost and skipped it. Take another one.
+                continue;
+            }
+            if (!entry.state.compare_exchange_strong(state,
+                                                     MakeState(lap, producer_index, kWriting))) {
+                // Skipped by the collector between the load and CAS
+                continue;
+            }
+            entry.value = value;
+            uint64_t writing = MakeState(lap, producer_index, kWriting);
+            // Commit fails only if the entry was abandoned as written by a dead process
+            return entry.state.compare_exchange_strong(writing,
+                                                       MakeState(lap, producer_index, kCommitted));
+        }
+    }
+
+    // Calls `handler(producer_index, value)` for up to `max_batch` values in FIFO order.
+    // Returns number of handled values.
+    //
+    // Draining stops at the first unfinished entry. If the entry stays unfinished longer than
+    // `stuck_timeout`, it is skipped when its position was reserved but never claimed, or when
+    // it was claimed by the process that is not alive anymore.
+    //
+    // If the collector is killed while draining, after restart it continues from the first entry
+    // which was not freed. A single value can be handled twice in this case.
+    template <class Handler>
+    unsigned CollectorDrain(Handler&& handler, unsigned max_batch,
+                            std::chrono::nanoseconds stuck_timeout = std::chrono::milliseconds{
+                                100}) {
+        uint64_t head = head_;
+        unsigned handled = 0;
+        while (handled < max_batch && head < tail_) {
+            uint64_t lap = head / Capacity;
+            Entry& entry = entries_[head % Capacity];
+            uint64_t state = entry.state;
+            if (Lap(state) > lap) {
+                // Freed by the collector killed before it stored the head
+                head++;
+                continue;
+            }
+            if (Tag(state) == kCommitted) {
+                handler(Writer(state), entry.value);
+                handled++;
+            } else if (Tag(state) != kAbandoned && !SkipStuck(head, entry, state, stuck_timeout)) {
+                break;
+            }
+            entry.state = MakeState(lap + 1, 0, kFree);
+            head++;
+        }
+        head_ = head;
+        return handled;
+    }
+
+    bool IsEmpty() const {
+        return head_ == tail_;
+    }
+
+private:
+    // Entry state packs lap of the position, index of the writer and a tag:
+    // free entry can be claimed by the producer of the position with the same lap.
+    static const uint64_t kFree = 0;
+    static const uint64_t kWriting = 1;
+    static const uint64_t kCommitted = 2;
+    static const uint64_t kAbandoned = 3;
+
+    static uint64_t MakeState(uint64_t lap, int writer, uint64_t tag) {
+        return (lap << 8) | (uint64_t(writer) << 2) | tag;
+    }
+    static uint64_t Lap(uint64_t state) {
+        return state >> 8;
+    }
+    static int Writer(uint64_t state) {
+        return (state >> 2) & 0x3f;
+    }
+    static uint64_t Tag(uint64_t state) {
+        return state & 3;
+    }
+
+    struct Entry {
+        std::atomic<uint64_t> state = 0;
+        T value;
+    };
+
+    // Decides if the unfinished entry at position `pos` can be skipped.
+    bool SkipStuck(uint64_t pos, Entry& entry, uint64_t state,
+                   std::chrono::nanoseconds stuck_timeout) {
+        int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+        if (stuck_pos_ != pos + 1) {
+            stuck_pos_ = pos + 1;
+            stuck_since_ = now;
+            return false;
+        }
+        if (now - stuck_since_ < stuck_timeout.count()) {
+            return false;
+        }
+        if (Tag(state) == kWriting) {
+            // Check that the writer is dead. Restarted writer abandons the entry by itself.
+            pid_t pid = producer_pids_[Writer(state)];
+            if (pid == 0 || kill(pid, 0) == 0 || errno != ESRCH) {
+                return false;
+            }
+        }
+        // Producer will notice that the entry is taken, if it is still alive
+        return entry.state.compare_exchange_strong(state, MakeState(Lap(state), 0, kAbandoned));
+    }
+
+    // Lets tests stop a push half-way, as if the producer was killed, see
+    // tests/mpsc_queue_test_access.h
+    friend struct MpscQueueTestAccess;
+
+    // Position of the next value to reserve
+    std::atomic<uint64_t> tail_ = 0;
+    // Position of the next value to drain. Written only by the collector
+    alignas(64) std::atomic<uint64_t> head_ = 0;
+    // 1 + position of the entry the collector is waiting for, and time it started to wait.
+    // Used only by the collector
+    uint64_t stuck_pos_ = 0;
+    int64_t stuck_since_ = 0;
+    // Pids of producers, used to check if a writer of unfinished entry is alive
+    std::atomic<pid_t> producer_pids_[Configuration::number_of_processes] = {};
+    alignas(64) Entry entries_[Capacity];
+};
+
+#endif
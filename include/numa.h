@@ -0,0 +1,82 @@
+#ifndef _NUMA_H_
+#define _NUMA_H_
+
+#include <fstream>
+#include <sched.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+// NUMA topology read from sysfs, without libnuma
+
+// Parses list of numbers in the sysfs format, e.g. "0-3,8,10-11"
+inline std::vector<int> ParseSysfsList(const std::string& list) {
+    std::vector<int> result;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int i = first; i <= last; i++) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+inline std::vector<int> ReadSysfsList(const std::string& path) {
+    std::ifstream file(path);
+    std::string list;
+    std::getline(file, list);
+    return ParseSysfsList(list);
+}
+
+// Online NUMA nodes. Machine without NUMA has a single node 0.
+inline std::vector<int> NumaNodes() {
+    std::vector<int> nodes = ReadSysfsList("/sys/devices/system/node/online");
+    if (nodes.empty()) {
+        nodes.push_back(0);
+    }
+    return nodes;
+}
+
+// CPUs of the NUMA node
+inline std::vector<int> NumaNodeCpus(int node) {
+    return ReadSysfsList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+}
+
+// NUMA node of the CPU the calling thread runs on
+inline int CurrentNumaNode() {
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+        return 0;
+    }
+    return node;
+}
+
+// Restricts the calling thread to CPUs of the NUMA node.
+// Memory first touched by the thread after that is allocated on the node.
+inline void PinToNumaNode(int node) {
+    std::vector<int> cpus = NumaNodeCpus(node);
+    if (cpus.empty()) {
+        throw std::runtime_error("NUMA node " + std::to_string(node) + " has no CPUs");
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        throw std::runtime_error("Can't pin to NUMA node " + std::to_string(node));
+    }
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef _NUMA_REPLICA_H_
+#define _NUMA_REPLICA_H_
+
+#include <atomic>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <chrono>
+#include <stdint.h>
+#include <string>
+
+#include <channel_segment.h>
+#include <config.h>
+#include <message_history.h>
+#include <seqlock_container.h>
+#include <shared_segment.h>
+
+namespace bipc = boost::interprocess;
+
+// Copy of the most recent message of a channel, kept in memory of a single NUMA node.
+// Consumers on the node read it instead of the channel, so they don't read remote memory.
+//
+// All class members are zero initialized. This allows to skip constructor call
+// when class instance is created in the zero initialized memory.
+struct ReplicaSegment {
+    // Value of steady_clock when the relay last confirmed that the replica is up to date.
+    // Consumers don't trust the replica if the relay is not running.
+    std::atomic<uint64_t> refreshed_ns = 0;
+    // Messages have the same generations as in the channel. Readers don't write to the replica,
+    // so reading doesn't move cache lines between consumers.
+    SeqlockContainer container;
+};
+
+// Name of the shared memory object of the replica of channel `sh_name` on NUMA node `node`
+inline std::string ReplicaName(const std::string& sh_name, int node) {
+    return sh_name + "_node" + std::to_string(node);
+}
+
+// Keeps the replica of a channel on a NUMA node up to date.
+//
+// Relay must run on the node (see `PinToNumaNode`): it creates the replica and is the first to
+// write to it, so the replica memory is allocated on the node.
+//
+// Relay reads the channel's history, which is not locked by readers, so the relay doesn't need a
+// lock bit in the channel. Message is copied only if the generation changed.
+// Only one relay of the channel can run on the node.
+class ReplicaRelay {
+public:
+    // Throws bipc::interprocess_exception if the channel doesn't exist yet
+    ReplicaRelay(const std::string& sh_name, int node)
+        : channel_obj_(bipc::open_only, sh_name.c_str(), bipc::read_only),
+          channel_region_(channel_obj_, bipc::read_only),
+          channel_(static_cast<const ChannelSegment*>(channel_region_.get_address())),
+          replica_(ReplicaName(sh_name, node)) {
+        // Reset unfinished write of the previous relay
+        replica_->container.WriterReset();
+    }
+
+    // Copies the most recent message if it changed. Returns true if the message was copied.
+    bool Poll(uint64_t now_ns) {
+        const MessageHistory& history = channel_->history;
+        uint64_t generation = history.LastGeneration();
+        bool copied = false;
+        if (generation != 0 && generation != replica_->container.Generation()) {
+            HistoryEntry entry;
+            // Entry is overwritten only if history_length messages were published meanwhile,
+            // then the newer message is copied
+            while (!history.ReaderGet(generation, entry)) {
+                generation = history.LastGeneration();
+            }
+            replica_->container.WriterUpdateMessage(entry.message, generation);
+            copied = true;
+        }
+        // Refresh time is written rarely, so consumers' cache lines with it stay valid
+        uint64_t refresh_period_ns =
+            std::chrono::nanoseconds{Configuration::replica_refresh_period}.count();
+        if (copied || now_ns - refreshed_ns_ >= refresh_period_ns) {
+            replica_->refreshed_ns.store(now_ns, std::memory_order_release);
+            refreshed_ns_ = now_ns;
+        }
+        return copied;
+    }
+
+    bool Poll() {
+        return Poll(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+    }
+
+private:
+    bipc::shared_memory_object channel_obj_;
+    bipc::mapped_region channel_region_;
+    const ChannelSegment* channel_;
+    SharedSegment<ReplicaSegment> replica_;
+    // Last written refresh time
+    uint64_t refreshed_ns_ = 0;
+};
+
+#endif
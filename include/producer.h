@@ -0,0 +1,199 @@
+#ifndef _PRODUCER_H_
+#define _PRODUCER_H_
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <string>
+
+#include <auto_tuner.h>
+#include <channel_segment.h>
+#include <config.h>
+#include <container_strategy.h>
+#include <message.h>
+#include <tuning_cache.h>
+
+namespace bipc = boost::interprocess;
+
+// Producer selects the container strategy of the channel on the first start: the fastest strategy
+// of the machine calibration (see `TuningCache`) is persisted in the channel settings. Later starts
+// keep the persisted strategy, unless it is given explicitly or `Tune` is called.
+class Producer {
+public:
+    // strategy - container strategy of the channel, Unset keeps the persisted one or tunes the
+    // channel if it wasn't tuned yet
+    // tuning_obj_name - shared memory object with the calibration of the machine, see `TuningCache`
+    Producer(int process_index, ContainerStrategy strategy = ContainerStrategy::Unset,
+             const std::string& tuning_obj_name = Configuration::tuning_obj_name)
+        : Producer(ChannelName(process_index), strategy, tuning_obj_name) {
+        SetPublisher(process_index);
+    }
+
+    // Creates producer of a channel with shared memory object `sh_name`.
+    // Used for derived channels, which are not bound to process index.
+    explicit Producer(const std::string& sh_name,
+                      ContainerStrategy strategy = ContainerStrategy::Unset,
+                      const std::string& tuning_obj_name = Configuration::tuning_obj_name)
+        : tuning_obj_name_(tuning_obj_name) {
+        // Create or open shared memory object. Create on fresh start,
+        // open on starts after crash.
+        shared_mem_obj_ =
+            bipc::shared_memory_object(bipc::open_or_create, sh_name.c_str(), bipc::read_write);
+        shared_mem_obj_.truncate(sizeof(ChannelSegment));
+        mem_region_ = bipc::mapped_region(shared_mem_obj_, bipc::read_write);
+
+        // If this is a fresh start, then ChannelSegment must be initialized,
+        // if this is a start after crash, then ChannelSegment should not be changed.
+        //
+        // Shared memory on creation is filled with zeroes and ChannelSegment members are
+        // initialized with zeros. That's why we can just cast memory, without the need to
+        // optionally call the ChannelSegment's constructor
+        segment_ptr_ = static_cast<ChannelSegment*>(mem_region_.get_address());
+
+        // Reset old unfinished writes
+        segment_ptr_->container.WriterReset();
+        segment_ptr_->seqlock.WriterReset();
+        segment_ptr_->inline_atomic.WriterReset();
+
+        strategy_ = Strategy();
+        if (strategy != ContainerStrategy::Unset) {
+            SetStrategy(strategy);
+            ChannelSettings& settings = segment_ptr_->settings;
+            std::fill(std::begin(settings.cost_ns), std::end(settings.cost_ns), 0);
+            settings.calibration_readers = 0;
+        } else if (Strategy() == ContainerStrategy::Unset) {
+            ApplyTuning(TuningCache(tuning_obj_name_).Report());
+        }
+
+        // Write could be interrupted after the container was updated, but before the history
+        AppendCurrentToHistory();
+    }
+
+    void UpdateMessage(const Message& msg) {
+        uint64_t timestamp_ns = TimestampNs();
+        uint64_t generation = Generation() + 1;
+        WriteContainer(strategy_, msg, generation);
+        segment_ptr_->history.WriterAppend(timestamp_ns, msg, generation);
+        segment_ptr_->filters.WriterEvaluate(msg);
+    }
+
+    // Prefetches the memory which the next `UpdateMessage` will write. Should be called when the
+    // producer is idle, shortly before the next message, so the publish path doesn't pay for it.
+    void PrepareNextMessage() const {
+        if (strategy_ == ContainerStrategy::BitmaskCas || strategy_ == ContainerStrategy::Unset) {
+            segment_ptr_->container.WriterPrefetch();
+        }
+    }
+
+    // Calibrates container strategies on this machine again, switches the channel to the fastest
+    // one and persists the results in the channel settings
+    TuningReport Tune() {
+        TuningReport report = TuningCache(tuning_obj_name_).Recalibrate();
+        ApplyTuning(report);
+        return report;
+    }
+
+    // Records the process which publishes the channel. Consumers of the process can't be created
+    // for the channel, see `ChannelSettings::publisher_id`.
+    void SetPublisher(int process_index) {
+        segment_ptr_->settings.publisher_id = process_index + 1;
+    }
+
+    ContainerStrategy Strategy() const {
+        return segment_ptr_->settings.strategy;
+    }
+
+    // Persisted settings of the channel
+    const ChannelSettings& Settings() const {
+        return segment_ptr_->settings;
+    }
+
+private:
+    // Timestamp of history entries, in the same unit as watermarks of `MergeReader`
+    static uint64_t TimestampNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void ApplyTuning(const TuningReport& report) {
+        ChannelSettings& settings = segment_ptr_->settings;
+        std::copy(std::begin(report.cost_ns), std::end(report.cost_ns), settings.cost_ns);
+        settings.calibration_readers = report.readers;
+        SetStrategy(report.strategy);
+    }
+
+    // Generation of the most recent message of the channel
+    uint64_t Generation() const {
+        switch (strategy_) {
+        case ContainerStrategy::Seqlock:
+            return segment_ptr_->seqlock.Generation();
+        case ContainerStrategy::InlineAtomic:
+            return segment_ptr_->inline_atomic.Generation();
+        default:
+            return segment_ptr_->container.Generation();
+        }
+    }
+
+    const Message* CurrentMessage() const {
+        switch (strategy_) {
+        case ContainerStrategy::Seqlock:
+            return segment_ptr_->seqlock.WriterCurrentMessage();
+        case ContainerStrategy::InlineAtomic:
+            return segment_ptr_->inline_atomic.WriterCurrentMessage();
+        default:
+            return segment_ptr_->container.WriterCurrentMessage();
+        }
+    }
+
+    void WriteContainer(ContainerStrategy strategy, const Message& msg, uint64_t generation) {
+        switch (strategy) {
+        case ContainerStrategy::Seqlock:
+            segment_ptr_->seqlock.WriterUpdateMessage(msg, generation);
+            break;
+        case ContainerStrategy::InlineAtomic:
+            segment_ptr_->inline_atomic.WriterUpdateMessage(msg, generation);
+            break;
+        default:
+            segment_ptr_->container.WriterUpdateMessage(msg, generation);
+            break;
+        }
+    }
+
+    // Moves the most recent message to the container of the new strategy before switching, so
+    // consumers don't lose it. The moved message keeps its generation: it is the same message,
+    // and consumers which have processed it (see `Consumer::Commit`) don't process it again.
+    // If the producer is killed before the switch, the old strategy stays.
+    void SetStrategy(ContainerStrategy strategy) {
+        if (strategy_ == strategy) {
+            return;
+        }
+        if (const Message* msg = CurrentMessage()) {
+            WriteContainer(strategy, *msg, Generation());
+        }
+        segment_ptr_->settings.strategy = strategy;
+        strategy_ = strategy;
+        AppendCurrentToHistory();
+    }
+
+    // Generations of the history are the same as generations of the container. Appends the most
+    // recent message to the history if it is missing there.
+    void AppendCurrentToHistory() {
+        const Message* msg = CurrentMessage();
+        if (msg && segment_ptr_->history.LastGeneration() < Generation()) {
+            segment_ptr_->history.WriterAppend(TimestampNs(), *msg, Generation());
+        }
+    }
+
+    // Strategy of the channel, only the producer changes it
+    ContainerStrategy strategy_ = ContainerStrategy::Unset;
+    std::string tuning_obj_name_;
+
+    bipc::shared_memory_object shared_mem_obj_;
+    bipc::mapped_region mem_region_;
+    ChannelSegment* segment_ptr_ = nullptr;
+};
+
+#endif
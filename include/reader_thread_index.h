@@ -0,0 +1,99 @@
+#ifndef _READER_THREAD_INDEX_H_
+#define _READER_THREAD_INDEX_H_
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <config.h>
+
+// Process-local allocator of reader thread indices.
+//
+// Each thread that reads from shared containers needs its own lock bit, see
+// `SharedDataContainer::ReaderIndex`. A thread gets an index from 0 to
+// `Configuration::reader_threads_per_process - 1` on the first call of `Get` and returns it
+// back on thread exit, so the index can be reused by threads started later.
+//
+// Locks which a thread left on exit are released by exit listeners before the index is returned,
+// so the next thread getting the same index doesn't inherit them.
+//
+// Indices are not stored in shared memory: after a restart of the process all of them are free
+// again, and locks made by the threads of the previous run are released by `ReaderReset`.
+class ReaderThreadIndex {
+public:
+    // Releases everything held with the index of an exiting thread. Called by the exiting thread.
+    class ExitListener {
+    public:
+        virtual void OnThreadExit(int thread_index) = 0;
+
+    protected:
+        ~ExitListener() = default;
+    };
+
+    // Returns index of the calling thread. Allocates the index on the first call.
+    // Throws if all indices are taken by other threads.
+    static int Get() {
+        thread_local Holder holder;
+        return holder.index;
+    }
+
+    // Registers listener, which is called on exit of every thread having an index.
+    // Listener must be removed before it is destroyed.
+    static void AddExitListener(ExitListener* listener) {
+        std::lock_guard<std::mutex> lock(listeners_mutex_);
+        listeners_.push_back(listener);
+    }
+
+    static void RemoveExitListener(ExitListener* listener) {
+        std::lock_guard<std::mutex> lock(listeners_mutex_);
+        listeners_.erase(std::remove(listeners_.begin(), listeners_.end(), listener),
+                         listeners_.end());
+    }
+
+private:
+    // Holds the index while the thread is alive.
+    struct Holder {
+        Holder() : index(Acquire()) {}
+        ~Holder() {
+            {
+                std::lock_guard<std::mutex> lock(listeners_mutex_);
+                for (ExitListener* listener : listeners_) {
+                    listener->OnThreadExit(index);
+                }
+            }
+            Release(index);
+        }
+        int index;
+    };
+
+    static int Acquire() {
+        uint64_t current_value = used_mask_;
+        int index;
+        do {
+            index = 0;
+            while (index < int(Configuration::reader_threads_per_process) &&
+                   (current_value & (uint64_t{1} << index))) {
+                index++;
+            }
+            if (index == int(Configuration::reader_threads_per_process)) {
+                throw std::runtime_error("No free reader thread indices");
+            }
+        } while (!used_mask_.compare_exchange_weak(current_value,
+                                                   current_value | (uint64_t{1} << index)));
+        return index;
+    }
+
+    static void Release(int index) {
+        used_mask_.fetch_and(~(uint64_t{1} << index));
+    }
+
+    // Bit is set if corresponding index is used by some thread
+    inline static std::atomic<uint64_t> used_mask_ = 0;
+    // Listeners are added and removed rarely, e.g. when consumers are created
+    inline static std::mutex listeners_mutex_;
+    inline static std::vector<ExitListener*> listeners_;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef _RT_MODE_H_
+#define _RT_MODE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Settings of the real-time mode
+struct RtOptions {
+    // SCHED_FIFO priority, zero keeps the default scheduling policy
+    int priority = 50;
+    // CPU to pin the process to, -1 keeps the affinity. Should be a CPU isolated from other
+    // tasks (isolcpus, nohz_full), because the hot loop never gives the CPU away.
+    int cpu = -1;
+    // Size of the stack to prefault
+    size_t stack_bytes = 256 * 1024;
+};
+
+// Prepares the process to run the hot loop without page faults:
+// locks all current and future memory (which also faults in the mapped shared memory objects),
+// stops malloc from returning memory to the system, prefaults the stack, pins the process to
+// the CPU and switches it to SCHED_FIFO.
+// Should be called after all shared memory objects are mapped. Throws std::runtime_error.
+void EnterRtMode(const RtOptions& options);
+
+// Number of heap allocations made by the process.
+// Counted by the replaced operator new, which is defined in rt_mode.cpp.
+uint64_t HeapAllocationCount();
+
+// Verifies that the steady state of the hot loop doesn't page-fault and doesn't allocate.
+// Page faults are counted for the calling thread, allocations for the whole process.
+class RtVerifier {
+public:
+    // Starts the steady state
+    void Start();
+
+    // Page faults of the calling thread since Start
+    uint64_t PageFaults() const;
+
+    // Heap allocations since Start
+    uint64_t Allocations() const;
+
+    // Throws std::runtime_error if there were page faults or allocations since Start
+    void Check() const;
+
+private:
+    static uint64_t ThreadPageFaults();
+
+    uint64_t start_faults_ = 0;
+    uint64_t start_allocations_ = 0;
+};
+
+#endif
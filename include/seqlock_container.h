@@ -0,0 +1,99 @@
+#ifndef _SEQLOCK_CONTAINER_H_
+#define _SEQLOCK_CONTAINER_H_
+
+#include <atomic>
+#include <stdint.h>
+
+#include <message.h>
+
+// The most recent message protected by sequence counters instead of locks.
+// Readers don't write to shared memory, so they don't contend with each other.
+//
+// There are two slots. Producer writes a new message to the slot which is not current and then
+// switches the current slot. If the producer is killed while writing, the current slot still
+// has the previous complete message, and readers are not blocked.
+//
+// All class members are zero initialized. This allows to skip constructor call
+// when class instance is created in the zero initialized memory.
+class SeqlockContainer {
+public:
+    bool IsEmpty() const {
+        return generation_ == 0;
+    }
+
+    // Returns generation of the most recent message, zero for the empty container
+    uint64_t Generation() const {
+        return generation_;
+    }
+
+    // Copies the most recent message and its generation. Returns false for the empty container.
+    bool ReaderRead(Message& out, uint64_t& generation) const {
+        while (true) {
+            const Slot& slot = slots_[current_slot_.load(std::memory_order_acquire)];
+            uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq == 0) {
+                return false;
+            }
+            if (seq & 1) {
+                // Slot stopped being current and is rewritten, reread current slot
+                continue;
+            }
+            out = slot.message;
+            generation = slot.generation;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == seq) {
+                return true;
+            }
+        }
+    }
+
+    // Returns the most recent message, nullptr for the empty container.
+    // Only the writer can use it, because only the writer changes messages.
+    const Message* WriterCurrentMessage() const {
+        return IsEmpty() ? nullptr : &slots_[current_slot_].message;
+    }
+
+    void WriterUpdateMessage(const Message& msg, uint64_t generation) {
+        int next_slot = 1 - current_slot_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[next_slot];
+        // Sequence is odd while the slot is written. After a crash during write it is already odd.
+        uint64_t seq = slot.seq.load(std::memory_order_relaxed) | 1;
+        slot.seq.store(seq, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.message = msg;
+        slot.generation = generation;
+        slot.seq.store(seq + 1, std::memory_order_release);
+
+        current_slot_.store(next_slot, std::memory_order_release);
+        generation_.store(generation, std::memory_order_release);
+    }
+
+    void WriterUpdateMessage(const Message& msg) {
+        WriterUpdateMessage(msg, generation_ + 1);
+    }
+
+    // Fixes the state after crash during write.
+    // Slot which was written during the crash stays invalid until the next write rewrites it:
+    // a reader which loaded its index before the crash would read a torn message otherwise.
+    void WriterReset() {
+        const Slot& current = slots_[current_slot_];
+        if (current.seq != 0) {
+            generation_ = current.generation;
+        }
+    }
+
+private:
+    friend struct SeqlockContainerTestAccess;
+
+    struct Slot {
+        // Odd while the message is written, zero if the slot was never written
+        std::atomic<uint64_t> seq = 0;
+        uint64_t generation = 0;
+        Message message;
+    };
+    std::atomic<int> current_slot_ = 0;
+    std::atomic<uint64_t> generation_ = 0;
+    Slot slots_[2];
+};
+
+#endif
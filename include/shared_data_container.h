@@ -7,108 +7,181 @@
 #include <config.h>
 #include <message.h>
 
+// How the writer chooses a free slot for a new message
+enum class SlotPolicy {
+    // The first free slot in index order
+    FirstFree,
+    // The slot released by the writer on the previous write, if it is not locked at the moment.
+    // The writer wrote this slot recently, so its message is likely still in the writer's cache.
+    // Readers which locked and unlocked it meanwhile have taken only the cache line with its lock
+    // bits. Otherwise the first free slot.
+    RecentlyFreed,
+};
+
+// Most recent message of type T. Readers lock slots with bits in per-slot masks.
+//
 // All class members are zero initialized. This allows to skip constructor call
 // when class instance is created in the zero initialized memory.
-class SharedDataContainer {
+template <class T, SlotPolicy Policy = SlotPolicy::RecentlyFreed>
+class BasicSharedDataContainer {
 public:
     bool IsEmpty() const {
         return current_slot_id_ == 0;
     }
 
-    // Locks slot with the most recent message by process with index `process_index`.
-    // Slot won't be emptied until corresponding unlock by the same process.
-    // Locks can't be nested, and the same slot can be locked by multiple processes.
+    // Returns generation of the most recent message, zero for the empty container.
+    // Generation is a number of the message starting from 1, every write increases it.
+    // Allows to check that the message wasn't updated since the last read without locking.
+    uint64_t Generation() const {
+        return generation_;
+    }
+
+    // Returns index of the reader thread `thread_index` of process `process_index`.
+    // Every reader thread has its own lock bit, so threads of the same process can lock
+    // messages independently.
+    static int ReaderIndex(int process_index, int thread_index) {
+        return process_index * Configuration::reader_threads_per_process + thread_index;
+    }
+
+    // Locks slot with the most recent message by reader with index `reader_index`.
+    // Slot won't be emptied until corresponding unlock by the same reader.
+    // Locks can't be nested, and the same slot can be locked by multiple readers.
     //
     // Function returns a handle to get message and to unlock it. Handle is valid until
     // `ReaderUnlock` call.
     //
-    // Precondition: Single process should not lock several slots at the same time. This is not
+    // Precondition: Single reader should not lock several slots at the same time. This is not
     // checked here. This should be checked by the class user.
-    int ReaderLock(int process_index) {
+    int ReaderLock(int reader_index) {
         if (current_slot_id_ == 0) {
             throw std::runtime_error("ReaderLock should not be called for empty container");
         }
-        int slot_index;
-        uint32_t current_value, new_value;
 
-        // To lock the most recent slot, one needs to set `process_index` bit in the
+        // To lock the most recent slot, one needs to set `reader_index` bit in the
         // `slots[current_slot_id_ - 1].used_by` field. But this whole operation can't be done
         // atomically. While setting the bit, new messages can be written and the slot can be
         // (partially) overwritten. It is ok, if the slot stops being the most recent, but it is not
         // ok if slot's message is (partially) overwritten.
         // To prevent this one must be sure that the locking slot is still used.
         // Use CAS for that. If it fails, reread current_slot_id_ as it may change and try again.
-        do {
+        while (true) {
             // current_slot_id_ value can change, save current value it
-            slot_index = current_slot_id_ - 1;
-            current_value = slots[slot_index].used_by;
+            int slot_index = current_slot_id_ - 1;
+            ReaderMask current_value = slots[slot_index].used_by;
             if ((current_value & Slot::used_by_writer) == 0) {
                 // slot is not used, because new message have been written.
                 // It is unsafe to lock the slot. Repeat to get newer slot.
                 continue;
             }
-            if (current_value & (1 << process_index)) {
-                throw std::runtime_error("ReaderLockDouble lock by the same process");
+            if (current_value & ReaderBit(reader_index)) {
+                throw std::runtime_error("ReaderLockDouble lock by the same reader");
             }
-            new_value = current_value | (1 << process_index);
-        } while (
-            !atomic_compare_exchange_weak(&slots[slot_index].used_by, &current_value, new_value));
-
-        return slot_index;
+            if (atomic_compare_exchange_weak(&slots[slot_index].used_by, &current_value,
+                                             current_value | ReaderBit(reader_index))) {
+                return slot_index;
+            }
+        }
     }
 
-    // Unlocks slot locked by process with index process_index.
+    // Unlocks slot locked by reader with index reader_index.
     // Slot is specified by handle.
-    void ReaderUnlock(int process_index, int handle) {
+    void ReaderUnlock(int reader_index, int handle) {
         // Handle is an index of the slot.
-        uint32_t current_value = slots[handle].used_by;
-        if ((current_value & (1 << process_index)) == 0) {
+        ReaderMask current_value = slots[handle].used_by;
+        if ((current_value & ReaderBit(reader_index)) == 0) {
             throw std::runtime_error("Attempt to unlock not locked slot");
         }
         // clear the bit
-        std::atomic_fetch_and(&slots[handle].used_by, ~(1 << process_index));
+        std::atomic_fetch_and(&slots[handle].used_by, ~ReaderBit(reader_index));
     }
 
-    // Resets all locks made by the process.
+    // Resets all locks made by all reader threads of the process.
     // Usefully for recovery after the crash.
     void ReaderReset(int process_index) {
+        const ReaderMask process_mask =
+            ((ReaderMask{1} << Configuration::reader_threads_per_process) - 1)
+            << ReaderIndex(process_index, 0);
         // Unlock every slot locked by the process
         for (int i = 0, num = std::size(slots); i < num; ++i) {
-            if (slots[i].used_by & (1 << process_index)) {
-                std::atomic_fetch_and(&slots[i].used_by, ~(1 << process_index));
+            if (slots[i].used_by & process_mask) {
+                std::atomic_fetch_and(&slots[i].used_by, ~process_mask);
+            }
+        }
+    }
+
+    // Resets locks made by the single reader `reader_index`.
+    // Used when the reader thread exits, so the next thread with the same index starts clean.
+    void ReaderResetReader(int reader_index) {
+        const ReaderMask reader_bit = ReaderBit(reader_index);
+        for (int i = 0, num = std::size(slots); i < num; ++i) {
+            if (slots[i].used_by & reader_bit) {
+                std::atomic_fetch_and(&slots[i].used_by, ~reader_bit);
             }
         }
     }
 
     // Returns message by handle
-    Message* ReaderGetMessage(int handle) {
+    T* ReaderGetMessage(int handle) {
         return &slots[handle].message;
     }
 
-    // Writes new message
-    void WriterUpdateMessage(const Message& msg) {
-        // Find next free slot
-        int next_slot_index = [this]() {
-            for (int i = 0, num = std::size(slots); i < num; ++i) {
-                if (slots[i].used_by == 0)
-                    return i;
-            }
+    // Returns generation of the message by handle
+    uint64_t ReaderGetGeneration(int handle) const {
+        return slots[handle].generation;
+    }
+
+    // Returns the most recent message, nullptr for the empty container.
+    // Only the writer can use it without locking, because only the writer empties slots.
+    const T* WriterCurrentMessage() const {
+        return IsEmpty() ? nullptr : &slots[current_slot_id_ - 1].message;
+    }
+
+    // Writes new message, its generation is the generation of the previous message + 1
+    void WriterUpdateMessage(const T& msg) {
+        WriterUpdateMessage(msg, generation_ + 1);
+    }
+
+    // Writes new message with the given generation.
+    // Used when the channel moves the message between containers and keeps numbering.
+    void WriterUpdateMessage(const T& msg, uint64_t generation) {
+        int next_slot_index = FindFreeSlot();
+        if (next_slot_index == -1) {
             throw std::runtime_error("No free slots for writer");
-        }();
+        }
 
+        int old_slot_id = current_slot_id_;
         slots[next_slot_index].message = msg;
+        slots[next_slot_index].generation = generation;
         std::atomic_fetch_or(&slots[next_slot_index].used_by, Slot::used_by_writer);
 
-        int old_slot_id = current_slot_id_;
         current_slot_id_ = next_slot_index + 1;
+        generation_ = generation;
         // Clear used_by_writer bit in old slot if it exists
         if (old_slot_id > 0) {
             std::atomic_fetch_and(&slots[old_slot_id - 1].used_by, ~Slot::used_by_writer);
         }
+        recently_freed_slot_id_ = old_slot_id;
+    }
+
+    // Prefetches for write the slot which the next write will likely use.
+    // Should be called when the writer is idle, not on the publish path.
+    void WriterPrefetch() const {
+        int slot_index = FindFreeSlot();
+        if (slot_index == -1) {
+            return;
+        }
+        const char* begin = reinterpret_cast<const char*>(&slots[slot_index]);
+        for (size_t offset = 0; offset < sizeof(Slot); offset += kCacheLineSize) {
+            __builtin_prefetch(begin + offset, 1);
+        }
     }
 
     // Fixes the state after crash during write
     void WriterReset() {
+        // Write could be interrupted after the slot was published, but before generation update
+        if (current_slot_id_ > 0) {
+            generation_ = slots[current_slot_id_ - 1].generation;
+        }
         // Clear used_by_writer bit for all slots except current_slot_id_
         for (int i = 0, num = std::size(slots); i < num; ++i) {
             if ((i != current_slot_id_ - 1) && (slots[i].used_by & Slot::used_by_writer)) {
@@ -118,21 +191,60 @@ public:
     }
 
 private:
+    static const size_t kCacheLineSize = 64;
+
+    // Returns index of the slot for the next message according to Policy, -1 if there are no
+    // free slots.
+    // Policy only chooses among free slots, so it doesn't affect crash safety: the slot is not
+    // the current one and is not locked by readers.
+    int FindFreeSlot() const {
+        if (Policy == SlotPolicy::RecentlyFreed && recently_freed_slot_id_ > 0 &&
+            recently_freed_slot_id_ != current_slot_id_ &&
+            slots[recently_freed_slot_id_ - 1].used_by == 0) {
+            return recently_freed_slot_id_ - 1;
+        }
+        for (int i = 0, num = std::size(slots); i < num; ++i) {
+            if (slots[i].used_by == 0)
+                return i;
+        }
+        return -1;
+    }
+
+    using ReaderMask = uint64_t;
+    static_assert(std::atomic<ReaderMask>::is_always_lock_free,
+                  "lock bits are shared between processes and must be lock free");
+
+    static ReaderMask ReaderBit(int reader_index) {
+        return ReaderMask{1} << reader_index;
+    }
+
     struct Slot {
-        static const uint32_t used_by_writer = 1 << 31;
-        // 32-bit variable. Bits from 0 to 31 are set if slot is locked by process with
+        static const ReaderMask used_by_writer = ReaderMask{1} << 63;
+        // 64-bit variable. Bits from 0 to 62 are set if slot is locked by reader with
         // corresponding index. The highest bit (used_by_writer) is set if slot is used by writer.
-        std::atomic<uint32_t> used_by = 0;
-        Message message;
+        std::atomic<ReaderMask> used_by = 0;
+        // Generation of the message, written together with the message
+        uint64_t generation = 0;
+        T message;
     };
     // Id of the slot with the most recent message. Id is 1 + index of the slot.
     // Value zero is reserved for indication of an empty container.
     std::atomic<int> current_slot_id_ = 0;
-    // Assuming that a single process won't lock multiple slots, N+1 slots allow to always have an
-    // unused slot to write to. In the worst case all readers (N-1) lock
-    // different slots with old messages, Nth slot is used for current message, and one more is
-    // needed to write new message without overriding current.
-    Slot slots[Configuration::number_of_processes + 1];
+    // Generation of the message in the current slot
+    std::atomic<uint64_t> generation_ = 0;
+    // Id of the slot released by the writer on the last write, zero if none. Used only by the
+    // writer, a hint which is checked before use.
+    int recently_freed_slot_id_ = 0;
+    // Assuming that a single reader won't lock multiple slots and the writer's process doesn't
+    // read the container, (N-1)*T+2 slots allow to always have an unused slot to write to.
+    // In the worst case all reader threads of other processes ((N-1)*T) lock different slots
+    // with old messages, one more slot is used for current message, and one more is needed to
+    // write new message without overriding current.
+    // With a single reader thread per process (T=1) this is N+1 slots.
+    Slot slots[(Configuration::number_of_processes - 1) * Configuration::reader_threads_per_process +
+               2];
 };
 
+using SharedDataContainer = BasicSharedDataContainer<Message>;
+
 #endif
@@ -0,0 +1,48 @@
+#ifndef _SHARED_SEGMENT_H_
+#define _SHARED_SEGMENT_H_
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <string>
+
+namespace bipc = boost::interprocess;
+
+// Shared memory object with a single instance of T, opened by name by all processes.
+// The process which starts first creates the object.
+//
+// Shared memory on creation is filled with zeroes. T must be designed to be used in the zero
+// initialized memory without constructor call, the same way as SharedDataContainer.
+template <class T>
+class SharedSegment {
+public:
+    explicit SharedSegment(const std::string& name) {
+        shared_mem_obj_ =
+            bipc::shared_memory_object(bipc::open_or_create, name.c_str(), bipc::read_write);
+        shared_mem_obj_.truncate(sizeof(T));
+        mem_region_ = bipc::mapped_region(shared_mem_obj_, bipc::read_write);
+        ptr_ = static_cast<T*>(mem_region_.get_address());
+    }
+
+    // Opens existing object. Throws bipc::interprocess_exception if there is no such object.
+    SharedSegment(const std::string& name, bipc::open_only_t) {
+        shared_mem_obj_ =
+            bipc::shared_memory_object(bipc::open_only, name.c_str(), bipc::read_write);
+        mem_region_ = bipc::mapped_region(shared_mem_obj_, bipc::read_write);
+        ptr_ = static_cast<T*>(mem_region_.get_address());
+    }
+
+    T* operator->() const {
+        return ptr_;
+    }
+
+    T& operator*() const {
+        return *ptr_;
+    }
+
+private:
+    bipc::shared_memory_object shared_mem_obj_;
+    bipc::mapped_region mem_region_;
+    T* ptr_ = nullptr;
+};
+
+#endif
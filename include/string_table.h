@@ -0,0 +1,159 @@
+#ifndef _STRING_TABLE_H_
+#define _STRING_TABLE_H_
+
+#include <atomic>
+#include <stdexcept>
+#include <stdint.h>
+#include <string.h>
+#include <string_view>
+
+#include <config.h>
+
+// Append-only table which maps strings to stable 32-bit ids. Shared by all processes, so
+// producers publish ids of names, keys and labels instead of the strings.
+//
+// Table is lock-free. Getting string by id is wait-free.
+//
+// String bytes are appended to the arena and the entry with their position is committed before
+// the entry id is put to the hash index. So the index contains only complete entries. If a process
+// is killed while inserting, the table stays consistent: reserved space is just lost.
+//
+// All class members are zero initialized. This allows to skip constructor call
+// when class instance is created in the zero initialized memory.
+class StringTable {
+public:
+    static constexpr uint32_t kInvalidId = UINT32_MAX;
+
+    // Returns id of the string, inserts the string if it isn't in the table yet.
+    // Throws if the table is full.
+    uint32_t Intern(std::string_view str) {
+        uint32_t hash = Hash(str);
+        uint32_t new_id = kInvalidId;
+        for (uint32_t i = 0; i < kBucketsCount; i++) {
+            std::atomic<uint32_t>& bucket = buckets_[(hash + i) & (kBucketsCount - 1)];
+            uint32_t value = bucket.load(std::memory_order_acquire);
+            if (value == 0) {
+                if (new_id == kInvalidId) {
+                    new_id = Append(str, hash);
+                }
+                // Bucket stores id + 1, zero means empty bucket
+                if (bucket.compare_exchange_strong(value, new_id + 1, std::memory_order_acq_rel)) {
+                    return new_id;
+                }
+                // Another process has taken the bucket, it could insert the same string.
+                // Entry `new_id` stays unused in this case.
+            }
+            if (Matches(value - 1, str, hash)) {
+                return value - 1;
+            }
+        }
+        throw std::runtime_error("StringTable: no free buckets");
+    }
+
+    // Returns id of the string, or kInvalidId if the string is not in the table
+    uint32_t Find(std::string_view str) const {
+        uint32_t hash = Hash(str);
+        for (uint32_t i = 0; i < kBucketsCount; i++) {
+            uint32_t value =
+                buckets_[(hash + i) & (kBucketsCount - 1)].load(std::memory_order_acquire);
+            if (value == 0) {
+                return kInvalidId;
+            }
+            if (Matches(value - 1, str, hash)) {
+                return value - 1;
+            }
+        }
+        return kInvalidId;
+    }
+
+    // Sets `out` to the string with id `id`. Returns false if there is no such string.
+    // String view points to the shared memory and is valid while the table is mapped.
+    bool Lookup(uint32_t id, std::string_view& out) const {
+        if (id >= Configuration::string_table_capacity) {
+            return false;
+        }
+        const Entry& entry = entries_[id];
+        if (!entry.committed.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = std::string_view(arena_ + entry.offset, entry.length);
+        return true;
+    }
+
+private:
+    // Twice more buckets than entries keeps probe sequences short
+    static const uint32_t kBucketsCount = 2 * Configuration::string_table_capacity;
+    static_assert((kBucketsCount & (kBucketsCount - 1)) == 0, "capacity must be a power of two");
+
+    struct Entry {
+        // Set when offset, length, hash and the string bytes are written
+        std::atomic<uint32_t> committed = 0;
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        uint32_t hash = 0;
+    };
+
+    // FNV-1a
+    static uint32_t Hash(std::string_view str) {
+        uint32_t hash = 2166136261u;
+        for (char c : str) {
+            hash = (hash ^ uint8_t(c)) * 16777619u;
+        }
+        return hash;
+    }
+
+    bool Matches(uint32_t id, std::string_view str, uint32_t hash) const {
+        const Entry& entry = entries_[id];
+        return entry.hash == hash && entry.length == str.size() &&
+               memcmp(arena_ + entry.offset, str.data(), str.size()) == 0;
+    }
+
+    // Appends the string and commits its entry. Returns id of the entry.
+    uint32_t Append(std::string_view str, uint32_t hash) {
+        uint32_t id;
+        if (!Reserve(next_id_, 1, Configuration::string_table_capacity, id)) {
+            throw std::runtime_error("StringTable: no free entries");
+        }
+        uint32_t offset;
+        if (!Reserve(arena_used_, str.size(), sizeof(arena_), offset)) {
+            // Give the entry back if no entry was reserved after it, so inserts of short strings
+            // still get entries
+            uint32_t next_id = id + 1;
+            next_id_.compare_exchange_strong(next_id, id);
+            throw std::runtime_error("StringTable: no free space for strings");
+        }
+        memcpy(arena_ + offset, str.data(), str.size());
+        Entry& entry = entries_[id];
+        entry.offset = offset;
+        entry.length = str.size();
+        entry.hash = hash;
+        entry.committed.store(1, std::memory_order_release);
+        return id;
+    }
+
+    // Advances `counter` by `amount` and sets `start` to its previous value. Returns false and
+    // leaves the counter as is if it would pass `limit`, so failed inserts into the full table
+    // don't make the counter wrap around.
+    static bool Reserve(std::atomic<uint32_t>& counter, size_t amount, size_t limit,
+                        uint32_t& start) {
+        uint32_t current = counter.load();
+        do {
+            if (current > limit || amount > limit - current) {
+                return false;
+            }
+        } while (!counter.compare_exchange_weak(current, current + amount));
+        start = current;
+        return true;
+    }
+
+    // Id of the next entry
+    std::atomic<uint32_t> next_id_ = 0;
+    // Used bytes of the arena
+    std::atomic<uint32_t> arena_used_ = 0;
+    // Hash index. Contains id + 1 of committed entry, zero for empty bucket
+    std::atomic<uint32_t> buckets_[kBucketsCount] = {};
+    Entry entries_[Configuration::string_table_capacity];
+    char arena_[Configuration::string_table_bytes] = {};
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef _TUNING_CACHE_H_
+#define _TUNING_CACHE_H_
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <signal.h>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include <auto_tuner.h>
+#include <config.h>
+#include <shared_segment.h>
+
+// Content of the shared memory object with the calibration of the machine.
+//
+// All class members are zero initialized. This allows to skip constructor call
+// when class instance is created in the zero initialized memory.
+struct TuningSegment {
+    // Pid of the calibrating process in the high half, sequence in the low half. Sequence is odd
+    // while the report is written and zero if the machine was never calibrated.
+    std::atomic<uint64_t> state = 0;
+    TuningReport report;
+};
+
+// Calibration of container strategies shared by all channels of the machine.
+//
+// The machine is calibrated once, by the first producer which needs it. Other producers, including
+// producers of derived channels, take the cached report. Producers which start at the same time
+// wait for the single calibration, so calibrations don't compete with each other for CPUs and the
+// report reflects the machine rather than the contention. If the calibrating process is killed,
+// another one takes over.
+class TuningCache {
+public:
+    explicit TuningCache(const std::string& sh_name = Configuration::tuning_obj_name)
+        : segment_(sh_name) {}
+
+    // Returns the calibration of the machine. Calibrates if the machine wasn't calibrated yet.
+    TuningReport Report() {
+        return Acquire(false);
+    }
+
+    // Calibrates the machine again and replaces the cached report. If another process is
+    // calibrating right now, returns its report instead.
+    TuningReport Recalibrate() {
+        return Acquire(true);
+    }
+
+private:
+    static uint64_t MakeState(pid_t pid, uint32_t seq) {
+        return (uint64_t(uint32_t(pid)) << 32) | seq;
+    }
+    static pid_t Pid(uint64_t state) {
+        return pid_t(state >> 32);
+    }
+    static uint32_t Seq(uint64_t state) {
+        return uint32_t(state);
+    }
+
+    TuningReport Acquire(bool recalibrate) {
+        std::atomic<uint64_t>& state = segment_->state;
+        bool waited = false;
+        while (true) {
+            uint64_t current = state.load(std::memory_order_acquire);
+            uint32_t seq = Seq(current);
+            if (seq & 1) {
+                // Another process calibrates. Take over if it was killed.
+                pid_t pid = Pid(current);
+                if (kill(pid, 0) != 0 && errno == ESRCH &&
+                    state.compare_exchange_strong(current, MakeState(getpid(), seq))) {
+                    return Calibrate(seq);
+                }
+                waited = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+                continue;
+            }
+            if (seq != 0 && (!recalibrate || waited)) {
+                TuningReport report = segment_->report;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (state.load(std::memory_order_relaxed) == current) {
+                    return report;
+                }
+                continue;
+            }
+            if (state.compare_exchange_strong(current, MakeState(getpid(), seq + 1))) {
+                return Calibrate(seq + 1);
+            }
+        }
+    }
+
+    // Calibrates and publishes the report. `seq` is the odd sequence owned by this process.
+    TuningReport Calibrate(uint32_t seq) {
+        TuningReport report = AutoTuner::Calibrate();
+        segment_->report = report;
+        segment_->state.store(MakeState(0, seq + 1), std::memory_order_release);
+        return report;
+    }
+
+    SharedSegment<TuningSegment> segment_;
+};
+
+#endif
@@ -0,0 +1,316 @@
+#ifndef _WINDOW_AGGREGATES_H_
+#define _WINDOW_AGGREGATES_H_
+
+#include <algorithm>
+#include <chrono>
+#include <initializer_list>
+#include <limits>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <channel_segment.h>
+#include <message.h>
+#include <message_history.h>
+#include <producer.h>
+
+// Rolling aggregates over the most recent values of a single producer.
+//
+// Window keeps up to `Capacity` values which are not older than `duration` relatively to the most
+// recent value. Every update is O(1) amortized: sum is updated incrementally, minimum and maximum
+// are the fronts of monotonic deques.
+template <unsigned Capacity>
+class RollingWindow {
+public:
+    explicit RollingWindow(std::chrono::nanoseconds duration = std::chrono::nanoseconds::max())
+        : duration_ns_(duration.count()) {}
+
+    void Add(uint64_t timestamp_ns, double value) {
+        if (end_ - begin_ == Capacity) {
+            PopOldest();
+        }
+        Value& slot = values_[end_ % Capacity];
+        slot.timestamp_ns = timestamp_ns;
+        slot.value = value;
+        sum_ += value;
+        // Values which are not less than the new one will never be the minimum again
+        while (!min_deque_.IsEmpty() && At(min_deque_.Back()).value >= value) {
+            min_deque_.PopBack();
+        }
+        min_deque_.PushBack(end_);
+        while (!max_deque_.IsEmpty() && At(max_deque_.Back()).value <= value) {
+            max_deque_.PopBack();
+        }
+        max_deque_.PushBack(end_);
+        end_++;
+
+        // The new value is never dropped. Timestamp which goes back is treated as zero age, so
+        // such value doesn't drop values which are newer than it.
+        while (begin_ + 1 < end_ && timestamp_ns > At(begin_).timestamp_ns &&
+               timestamp_ns - At(begin_).timestamp_ns > duration_ns_) {
+            PopOldest();
+        }
+    }
+
+    unsigned Count() const {
+        return end_ - begin_;
+    }
+
+    double Sum() const {
+        return sum_;
+    }
+
+    // Aggregates of the empty window are zero
+    double Mean() const {
+        return Count() == 0 ? 0 : sum_ / Count();
+    }
+
+    double Min() const {
+        return Count() == 0 ? 0 : At(min_deque_.Front()).value;
+    }
+
+    double Max() const {
+        return Count() == 0 ? 0 : At(max_deque_.Front()).value;
+    }
+
+    // Change of the value per second between the oldest and the most recent values. Zero if
+    // timestamps went back.
+    double Rate() const {
+        if (Count() < 2) {
+            return 0;
+        }
+        const Value& first = At(begin_);
+        const Value& last = At(end_ - 1);
+        if (last.timestamp_ns <= first.timestamp_ns) {
+            return 0;
+        }
+        return (last.value - first.value) * 1e9 / (last.timestamp_ns - first.timestamp_ns);
+    }
+
+private:
+    struct Value {
+        uint64_t timestamp_ns;
+        double value;
+    };
+
+    // Deque of positions of values in the window
+    class PositionDeque {
+    public:
+        bool IsEmpty() const {
+            return head_ == tail_;
+        }
+        uint64_t Front() const {
+            return positions_[head_ % Capacity];
+        }
+        uint64_t Back() const {
+            return positions_[(tail_ - 1) % Capacity];
+        }
+        void PushBack(uint64_t pos) {
+            positions_[tail_++ % Capacity] = pos;
+        }
+        void PopBack() {
+            tail_--;
+        }
+        void PopFront() {
+            head_++;
+        }
+
+    private:
+        uint64_t positions_[Capacity];
+        uint64_t head_ = 0;
+        uint64_t tail_ = 0;
+    };
+
+    const Value& At(uint64_t pos) const {
+        return values_[pos % Capacity];
+    }
+
+    void PopOldest() {
+        sum_ -= At(begin_).value;
+        if (min_deque_.Front() == begin_) {
+            min_deque_.PopFront();
+        }
+        if (max_deque_.Front() == begin_) {
+            max_deque_.PopFront();
+        }
+        begin_++;
+    }
+
+    uint64_t duration_ns_;
+    Value values_[Capacity];
+    // Positions of the oldest value and the next value to add
+    uint64_t begin_ = 0;
+    uint64_t end_ = 0;
+    double sum_ = 0;
+    PositionDeque min_deque_;
+    PositionDeque max_deque_;
+};
+
+// Aggregates of windows of all producers
+struct WindowSummary {
+    unsigned count;
+    double mean;
+    double min;
+    double max;
+    // Sum of rates of all producers
+    double rate;
+};
+
+// Keeps rolling windows of several producers up to date with their histories.
+//
+// Aggregates of every window are also kept in arrays, so summary across producers is computed
+// with SIMD instructions.
+template <unsigned Capacity>
+class ProducerWindows {
+public:
+    ProducerWindows(const std::vector<const MessageHistory*>& histories,
+                    std::chrono::nanoseconds duration = std::chrono::nanoseconds::max()) {
+        for (const MessageHistory* history : histories) {
+            cursors_.emplace_back(*history);
+            windows_.emplace_back(duration);
+        }
+        sums_.resize(histories.size(), 0);
+        counts_.resize(histories.size(), 0);
+        mins_.resize(histories.size(), std::numeric_limits<double>::infinity());
+        maxs_.resize(histories.size(), -std::numeric_limits<double>::infinity());
+        rates_.resize(histories.size(), 0);
+    }
+
+    // Adds messages published since the last update to the windows.
+    // Returns number of added messages.
+    unsigned Update() {
+        unsigned added = 0;
+        HistoryEntry entry;
+        for (int i = 0, num = windows_.size(); i < num; i++) {
+            unsigned window_added = 0;
+            while (cursors_[i].Next(entry)) {
+                windows_[i].Add(entry.timestamp_ns, entry.message.val);
+                window_added++;
+            }
+            if (window_added != 0) {
+                const RollingWindow<Capacity>& window = windows_[i];
+                sums_[i] = window.Sum();
+                counts_[i] = window.Count();
+                mins_[i] = window.Min();
+                maxs_[i] = window.Max();
+                rates_[i] = window.Rate();
+                added += window_added;
+            }
+        }
+        return added;
+    }
+
+    const RollingWindow<Capacity>& Window(int index) const {
+        return windows_[index];
+    }
+
+    // Aggregates values in windows of all producers
+    WindowSummary Summary() const {
+        WindowSummary summary;
+        int num = windows_.size();
+        double sum = Sum(sums_.data(), num);
+        double count = Sum(counts_.data(), num);
+        summary.count = count;
+        summary.mean = count == 0 ? 0 : sum / count;
+        summary.min = count == 0 ? 0 : Min(mins_.data(), num);
+        summary.max = count == 0 ? 0 : Max(maxs_.data(), num);
+        summary.rate = Sum(rates_.data(), num);
+        return summary;
+    }
+
+private:
+    static double Sum(const double* values, int num) {
+        int i = 0;
+        double result = 0;
+#if defined(__SSE2__)
+        __m128d acc = _mm_setzero_pd();
+        for (; i + 2 <= num; i += 2) {
+            acc = _mm_add_pd(acc, _mm_loadu_pd(values + i));
+        }
+        result = _mm_cvtsd_f64(acc) + _mm_cvtsd_f64(_mm_unpackhi_pd(acc, acc));
+#endif
+        for (; i < num; i++) {
+            result += values[i];
+        }
+        return result;
+    }
+
+    // Empty windows have +inf minimum, so they don't affect the result
+    static double Min(const double* values, int num) {
+        int i = 0;
+        double result = std::numeric_limits<double>::infinity();
+#if defined(__SSE2__)
+        __m128d acc = _mm_set1_pd(result);
+        for (; i + 2 <= num; i += 2) {
+            acc = _mm_min_pd(acc, _mm_loadu_pd(values + i));
+        }
+        result = std::min(_mm_cvtsd_f64(acc), _mm_cvtsd_f64(_mm_unpackhi_pd(acc, acc)));
+#endif
+        for (; i < num; i++) {
+            result = std::min(result, values[i]);
+        }
+        return result;
+    }
+
+    // Empty windows have -inf maximum, so they don't affect the result
+    static double Max(const double* values, int num) {
+        int i = 0;
+        double result = -std::numeric_limits<double>::infinity();
+#if defined(__SSE2__)
+        __m128d acc = _mm_set1_pd(result);
+        for (; i + 2 <= num; i += 2) {
+            acc = _mm_max_pd(acc, _mm_loadu_pd(values + i));
+        }
+        result = std::max(_mm_cvtsd_f64(acc), _mm_cvtsd_f64(_mm_unpackhi_pd(acc, acc)));
+#endif
+        for (; i < num; i++) {
+            result = std::max(result, values[i]);
+        }
+        return result;
+    }
+
+    std::vector<HistoryCursor> cursors_;
+    std::vector<RollingWindow<Capacity>> windows_;
+    // Aggregates of every window
+    std::vector<double> sums_;
+    std::vector<double> counts_;
+    std::vector<double> mins_;
+    std::vector<double> maxs_;
+    std::vector<double> rates_;
+};
+
+// Publishes summary to derived channels, one channel per aggregate:
+// `<name>_mean`, `<name>_min`, `<name>_max` and `<name>_rate`.
+// Values are published as doubles, see `MessageToDouble`.
+// Channels are read by other processes, not by the publishing process `process_index`.
+class WindowSummaryPublisher {
+public:
+    WindowSummaryPublisher(const std::string& name, int process_index)
+        : mean_(DerivedChannelName(name + "_mean")),
+          min_(DerivedChannelName(name + "_min")),
+          max_(DerivedChannelName(name + "_max")),
+          rate_(DerivedChannelName(name + "_rate")) {
+        for (Producer* producer : {&mean_, &min_, &max_, &rate_}) {
+            producer->SetPublisher(process_index);
+        }
+    }
+
+    void Publish(const WindowSummary& summary) {
+        mean_.UpdateMessage(MessageFromDouble(summary.mean));
+        min_.UpdateMessage(MessageFromDouble(summary.min));
+        max_.UpdateMessage(MessageFromDouble(summary.max));
+        rate_.UpdateMessage(MessageFromDouble(summary.rate));
+    }
+
+private:
+    Producer mean_;
+    Producer min_;
+    Producer max_;
+    Producer rate_;
+};
+
+#endif
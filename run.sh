@@ -16,6 +16,17 @@ cmake --build build
 
 cleanup
 
+# logger prints output of all processes
+./build/Logger &
+
+# on NUMA machines consumers read replicas of channels kept by a relay on their node
+nodes=(/sys/devices/system/node/node[0-9]*)
+if (( ${#nodes[@]} > 1 )); then
+    for node in "${nodes[@]}"; do
+        ./build/Relay ${node##*node} &
+    done
+fi
+
 # pids of processes
 pids=()
 for ((i=0;i<COUNT;i++)); do
@@ -0,0 +1,17 @@
+#include <log_ring.h>
+
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+
+// Writes log records of all processes to stdout.
+// Single logger process should be started together with processes.
+int main() {
+    LogCollector collector(STDOUT_FILENO);
+    while (true) {
+        if (collector.Drain() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+    }
+    return 0;
+}
@@ -1,117 +1,35 @@
 #include <config.h>
+#include <consumer.h>
+#include <container_strategy.h>
+#include <cpu_relax.h>
+#include <log_ring.h>
 #include <message.h>
-#include <shared_data_container.h>
+#include <numa.h>
+#include <producer.h>
+#include <rt_mode.h>
 
 #include <algorithm>
-#include <boost/interprocess/mapped_region.hpp>
-#include <boost/interprocess/shared_memory_object.hpp>
 #include <chrono>
+#include <exception>
 #include <iostream>
 #include <random>
+#include <string>
 #include <thread>
 #include <vector>
 
-namespace bipc = boost::interprocess;
-
-class Producer {
-public:
-    Producer(int process_index) {
-        std::string sh_name(Configuration::shared_obj_name_prefix + std::to_string(process_index));
-
-        // Create or open shared memory object. Create on fresh start,
-        // open on starts after crash.
-        shared_mem_obj_ =
-            bipc::shared_memory_object(bipc::open_or_create, sh_name.c_str(), bipc::read_write);
-        shared_mem_obj_.truncate(sizeof(SharedDataContainer));
-        mem_region_ = bipc::mapped_region(shared_mem_obj_, bipc::read_write);
-
-        // If this is a fresh start, then SharedDataContainer must be initialized,
-        // if this is a start after crash, then SharedDataContainer should not be changed.
-        //
-        // Shared memory on creation is filled with zeroes and SharedDataContainer members are
-        // initialized with zeros. That's why we can just cast memory, without the need to
-        // optionally call the SharedDataContainer's constructor
-        shared_data_ptr_ = static_cast<SharedDataContainer*>(mem_region_.get_address());
-
-        // Reset old unfinished writes
-        shared_data_ptr_->WriterReset();
-    }
-
-    void UpdateMessage(const Message& msg) {
-        shared_data_ptr_->WriterUpdateMessage(msg);
-    }
-
-private:
-    bipc::shared_memory_object shared_mem_obj_;
-    bipc::mapped_region mem_region_;
-    SharedDataContainer* shared_data_ptr_ = nullptr;
-};
-
-class Consumer {
-public:
-    // current_process_index - index of current process
-    // producer_index - index of process-producer to read from
-    Consumer(int current_process_index, int producer_index)
-        : producer_process_index(producer_index), process_index_(current_process_index) {
-        std::string sh_name =
-            Configuration::shared_obj_name_prefix + std::to_string(producer_index);
-
-        // Wait until producer creates shared object
-        while (true) {
-            // shared_memory_object and mapped_region throw exceptions, if shared object is not
-            // available.
-            try {
-                shared_mem_obj_ =
-                    bipc::shared_memory_object(bipc::open_only, sh_name.c_str(), bipc::read_write);
-                mem_region_ = bipc::mapped_region(shared_mem_obj_, bipc::read_write);
-                // creation was successful
-                break;
-            } catch (bipc::interprocess_exception& err) {}
-        }
-
-        shared_data_ptr_ = static_cast<SharedDataContainer*>(mem_region_.get_address());
-
-        // Reset unfinished reads
-        shared_data_ptr_->ReaderReset(process_index_);
-    }
-
-    bool HasMessage() const {
-        return !shared_data_ptr_->IsEmpty();
-    }
-
-    Message* LockMessage() {
-        if (locked_message_handle_ != -1) {
-            throw std::runtime_error("Consumer: attempt to double lock a message");
-        }
-        if (!HasMessage()) {
-            throw std::runtime_error("Consumer: attempt to lock an empty message");
-        }
-        locked_message_handle_ = shared_data_ptr_->ReaderLock(process_index_);
-        return shared_data_ptr_->ReaderGetMessage(locked_message_handle_);
-    }
-
-    void UnlockMessage() {
-        if (locked_message_handle_ == -1) {
-            throw std::runtime_error("Consumer: attempt to unlock not locked message");
-        }
-        shared_data_ptr_->ReaderUnlock(process_index_, locked_message_handle_);
-        locked_message_handle_ = -1;
-    }
-
-public:
-    int producer_process_index;  // index of process-producer
-
-private:
-    bipc::shared_memory_object shared_mem_obj_;
-    bipc::mapped_region mem_region_;
-    int locked_message_handle_ = -1;
-    int process_index_;  // Index of current process
-    SharedDataContainer* shared_data_ptr_ = nullptr;
-};
+static void PrintUsage(const char* program) {
+    std::cout << "Usage: " << program
+              << " <index> [--retune] [--rt] [--cpu <cpu>] [--priority <prio>]\n"
+              << "  --retune           calibrate container strategy of the channel again\n"
+              << "  --rt               real-time mode: lock memory, spin instead of sleeping and\n"
+              << "                     verify that the loop doesn't page-fault or allocate\n"
+              << "  --cpu <cpu>        pin the process to the CPU in real-time mode\n"
+              << "  --priority <prio>  SCHED_FIFO priority in real-time mode, 0 keeps the policy\n";
+}
 
 int main(int argc, char** argv) {
     if (argc < 2) {
-        std::cout << "Usage: " << argv[0] << " <index>\n";
+        PrintUsage(argv[0]);
         return 1;
     }
     int process_index = std::stoi(argv[1]);
@@ -120,44 +38,125 @@ int main(int argc, char** argv) {
                   << "\n";
         return 1;
     }
+    bool retune = false;
+    bool rt = false;
+    RtOptions rt_options;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--retune") {
+            retune = true;
+        } else if (arg == "--rt") {
+            rt = true;
+        } else if (arg == "--cpu" && i + 1 < argc) {
+            rt_options.cpu = std::stoi(argv[++i]);
+        } else if (arg == "--priority" && i + 1 < argc) {
+            rt_options.priority = std::stoi(argv[++i]);
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
 
+    // Output goes through the shared log, the logger process prints it
+    LogWriter log(process_index);
     // Start with creating a producer to prevent deadlock
     Producer producer(process_index);
+    if (retune) {
+        producer.Tune();
+    }
+    // Report container strategy of the channel and the calibration results it is based on
+    const ChannelSettings& settings = producer.Settings();
+    for (int i = 0; i < kContainerStrategiesCount; i++) {
+        if (settings.cost_ns[i] != 0) {
+            log.Log(LogEvent::StrategyCost, int32_t(kContainerStrategies[i]), settings.cost_ns[i]);
+        }
+    }
+    log.Log(LogEvent::Strategy, int32_t(producer.Strategy()), settings.calibration_readers);
     // Create consumers, each consumer waits for its process-producer to create a shared object.
     std::vector<Consumer> consumers;
-    std::cout << process_index << ": waiting for other processes\n";
+    log.Log(LogEvent::Waiting);
     for (int i = 0; i < Configuration::number_of_processes; i++) {
         if (i != process_index) {
             consumers.emplace_back(process_index, i);
         }
     }
-    std::cout << process_index << ": ready\n";
+    log.Log(LogEvent::Ready);
 
     std::default_random_engine random_gen(std::random_device{}());
     std::uniform_int_distribution<unsigned> dist{1, 1'000'000};
 
+    // In real-time mode the hot loop must not page-fault, allocate or make syscalls.
+    // First iterations fault in lazily initialized state (e.g. reader thread index), after them
+    // every iteration is verified.
+    static const int kRtWarmupIterations = 3;
+    RtVerifier verifier;
+    if (rt) {
+        try {
+            EnterRtMode(rt_options);
+        } catch (std::exception& err) {
+            std::cerr << err.what() << "\n";
+            return 1;
+        }
+        // Replicas are attached now, the hot loop doesn't check the NUMA node
+        if (NumaNodes().size() > 1) {
+            for (Consumer& consumer : consumers) {
+                consumer.AttachReplica(CurrentNumaNode());
+            }
+        }
+    }
+
     // Constantly increasing variable. The value is used to construct producers message
     uint64_t prod_value = 0;
     while (true) {
         for (int i = 0, num = consumers.size(); i < num; i++) {
             Consumer& consumer = consumers[i];
-            if (consumer.HasMessage()) {
-                Message* msg = consumer.LockMessage();
-                std::cout << process_index << ": read info from " << consumer.producer_process_index
-                          << ": " << msg->val << "\n";
-                consumer.UnlockMessage();
+            Message msg;
+            uint64_t generation;
+            if (consumer.ReadMessage(msg, &generation)) {
+                // Message is processed once, also across restarts of the process
+                if (generation > consumer.CommittedGeneration()) {
+                    log.Log(LogEvent::Read, consumer.producer_process_index, msg.val);
+                    consumer.Commit(generation);
+                }
             } else {
-                std::cout << process_index << ": read info from " << consumer.producer_process_index
-                          << ": empty\n";
+                log.Log(LogEvent::ReadEmpty, consumer.producer_process_index);
             }
         }
 
         prod_value++;
-        std::cout << process_index << ": write " << prod_value << "\n";
+        log.Log(LogEvent::Write, 0, prod_value);
         producer.UpdateMessage(Message{prod_value});
 
-        // sleep for random time
-        std::this_thread::sleep_for(std::chrono::microseconds{dist(random_gen)});
+        auto pause = std::chrono::microseconds{dist(random_gen)};
+        if (!rt) {
+            // sleep for random time
+            std::this_thread::sleep_for(pause);
+            producer.PrepareNextMessage();
+            continue;
+        }
+
+        // Verification makes a syscall, so it is done in the idle part of the iteration
+        if (prod_value == kRtWarmupIterations) {
+            verifier.Start();
+        } else if (prod_value > kRtWarmupIterations) {
+            uint64_t faults = verifier.PageFaults();
+            uint64_t allocations = verifier.Allocations();
+            if (faults != 0 || allocations != 0) {
+                log.Log(LogEvent::RtViolation, int32_t(faults), allocations);
+                try {
+                    verifier.Check();
+                } catch (std::exception& err) {
+                    std::cerr << err.what() << "\n";
+                }
+                return 1;
+            }
+        }
+        // Spin instead of sleeping, sleep is a syscall
+        auto deadline = std::chrono::steady_clock::now() + pause;
+        while (std::chrono::steady_clock::now() < deadline) {
+            CpuRelax();
+        }
+        producer.PrepareNextMessage();
     }
     return 0;
 }
@@ -0,0 +1,49 @@
+#include <channel_segment.h>
+#include <config.h>
+#include <numa.h>
+#include <numa_replica.h>
+
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Keeps replicas of channels of all processes on a single NUMA node.
+// One relay should be started on every node, consumers on the node read the replicas.
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Usage: " << argv[0] << " <numa node>\n";
+        return 1;
+    }
+    int node = std::stoi(argv[1]);
+    try {
+        // Replicas are created after pinning, so their memory is allocated on the node
+        PinToNumaNode(node);
+    } catch (std::exception& err) {
+        std::cerr << err.what() << "\n";
+        return 1;
+    }
+
+    // Relay of the channel is created when the producer creates the channel
+    std::vector<std::unique_ptr<ReplicaRelay>> relays(Configuration::number_of_processes);
+    while (true) {
+        uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+        for (int i = 0; i < int(Configuration::number_of_processes); i++) {
+            if (!relays[i]) {
+                try {
+                    relays[i] = std::make_unique<ReplicaRelay>(ChannelName(i), node);
+                } catch (bipc::interprocess_exception& err) {
+                    continue;
+                }
+            }
+            relays[i]->Poll(now_ns);
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds{100});
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include <rt_mode.h>
+
+#include <algorithm>
+#include <alloca.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+#include <new>
+#include <sched.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+namespace {
+
+std::atomic<uint64_t> heap_allocations{0};
+
+void* Allocate(size_t size) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    // malloc(0) may return nullptr, operator new must return a unique pointer
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* AllocateAligned(size_t size, std::align_val_t alignment) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = nullptr;
+    size_t align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+    if (posix_memalign(&ptr, align, size == 0 ? 1 : size) != 0) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+[[noreturn]] void ThrowSystemError(const char* what) {
+    throw std::runtime_error(std::string("RT mode: ") + what + ": " + std::strerror(errno));
+}
+
+// Touches `bytes` of the stack below the current frame, so the stack pages are faulted in and,
+// after mlockall, stay resident
+__attribute__((noinline)) void PrefaultStack(size_t bytes) {
+    volatile char* stack = static_cast<volatile char*>(alloca(bytes));
+    for (size_t i = 0; i < bytes; i += 4096) {
+        stack[i] = 0;
+    }
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+    return Allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return Allocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return Allocate(size);
+    } catch (std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return Allocate(size);
+    } catch (std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    return AllocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return AllocateAligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+uint64_t HeapAllocationCount() {
+    return heap_allocations.load(std::memory_order_relaxed);
+}
+
+void EnterRtMode(const RtOptions& options) {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        ThrowSystemError("mlockall failed");
+    }
+    // Freed memory is kept by malloc, so later allocations don't fault in new pages
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    PrefaultStack(options.stack_bytes);
+
+    if (options.cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(options.cpu, &cpus);
+        if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+            ThrowSystemError("sched_setaffinity failed");
+        }
+    }
+    if (options.priority > 0) {
+        sched_param param{};
+        param.sched_priority = options.priority;
+        if (sched_setscheduler(0, SCHED_FIFO, &param) != 0) {
+            ThrowSystemError("sched_setscheduler failed");
+        }
+    }
+}
+
+void RtVerifier::Start() {
+    start_faults_ = ThreadPageFaults();
+    start_allocations_ = HeapAllocationCount();
+}
+
+uint64_t RtVerifier::PageFaults() const {
+    return ThreadPageFaults() - start_faults_;
+}
+
+uint64_t RtVerifier::Allocations() const {
+    return HeapAllocationCount() - start_allocations_;
+}
+
+void RtVerifier::Check() const {
+    uint64_t faults = PageFaults();
+    uint64_t allocations = Allocations();
+    if (faults != 0 || allocations != 0) {
+        throw std::runtime_error("RT mode: steady state made " + std::to_string(faults) +
+                                 " page faults and " + std::to_string(allocations) +
+                                 " heap allocations");
+    }
+}
+
+uint64_t RtVerifier::ThreadPageFaults() {
+    rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_minflt + usage.ru_majflt;
+}
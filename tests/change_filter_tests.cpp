@@ -0,0 +1,111 @@
+#include <change_filter.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <csignal>
+#include <new>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+TEST_CASE("Every message matches without filter") {
+    ChangeFilters filters;
+    REQUIRE_FALSE(filters.ConsumerTakeDirty(0));
+    filters.WriterEvaluate(Message{1});
+    REQUIRE(filters.ConsumerTakeDirty(0));
+    REQUIRE_FALSE(filters.ConsumerTakeDirty(0));
+}
+
+TEST_CASE("Threshold with deadband") {
+    ChangeFilters filters;
+    filters.ConsumerSetFilter(1, FilterConfig{FilterField::Value, FilterKind::Above, 100, 10});
+
+    filters.WriterEvaluate(Message{50});
+    REQUIRE_FALSE(filters.ConsumerTakeDirty(1));
+    filters.WriterEvaluate(Message{101});
+    REQUIRE(filters.ConsumerTakeDirty(1));
+    // Jitter around the threshold doesn't match
+    filters.WriterEvaluate(Message{95});
+    filters.WriterEvaluate(Message{105});
+    REQUIRE_FALSE(filters.ConsumerTakeDirty(1));
+    // Drop below deadband rearms the filter
+    filters.WriterEvaluate(Message{80});
+    filters.WriterEvaluate(Message{105});
+    REQUIRE(filters.ConsumerTakeDirty(1));
+
+    // Filter of other consumer is independent
+    REQUIRE(filters.ConsumerTakeDirty(0));
+}
+
+TEST_CASE("Below threshold") {
+    ChangeFilters filters;
+    filters.ConsumerSetFilter(0, FilterConfig{FilterField::Value, FilterKind::Below, 10, 5});
+    filters.WriterEvaluate(Message{20});
+    REQUIRE_FALSE(filters.ConsumerTakeDirty(0));
+    filters.WriterEvaluate(Message{5});
+    REQUIRE(filters.ConsumerTakeDirty(0));
+    filters.WriterEvaluate(Message{12});
+    filters.WriterEvaluate(Message{5});
+    REQUIRE_FALSE(filters.ConsumerTakeDirty(0));
+}
+
+TEST_CASE("Delta filter") {
+    ChangeFilters filters;
+    filters.ConsumerSetFilter(0, FilterConfig{FilterField::Value, FilterKind::Delta, 0, 10});
+    filters.WriterEvaluate(Message{100});
+    REQUIRE(filters.ConsumerTakeDirty(0));
+    filters.WriterEvaluate(Message{105});
+    filters.WriterEvaluate(Message{95});
+    REQUIRE_FALSE(filters.ConsumerTakeDirty(0));
+    filters.WriterEvaluate(Message{110});
+    REQUIRE(filters.ConsumerTakeDirty(0));
+}
+
+TEST_CASE("Wait for matching message") {
+    ChangeFilters filters;
+    REQUIRE_FALSE(filters.ConsumerWaitDirty(0, std::chrono::milliseconds{1}));
+
+    std::thread producer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        filters.WriterEvaluate(Message{1});
+    });
+    REQUIRE(filters.ConsumerWaitDirty(0, std::chrono::seconds{10}));
+    producer.join();
+    REQUIRE(filters.ConsumerTakeDirty(0));
+}
+
+TEST_CASE("Wait of a killed consumer is tracked only for that consumer") {
+    // Filters are shared with a child process, which is killed while waiting
+    void* memory = mmap(nullptr, sizeof(ChangeFilters), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    REQUIRE(memory != MAP_FAILED);
+    ChangeFilters* filters = new (memory) ChangeFilters();
+    pid_t child = fork();
+    if (child == 0) {
+        filters->ConsumerWaitDirty(1, std::chrono::seconds{100});
+        _exit(0);
+    }
+    while (!filters->HasWaiters(1)) {
+        std::this_thread::yield();
+    }
+    kill(child, SIGKILL);
+    REQUIRE(waitpid(child, nullptr, 0) == child);
+    REQUIRE(filters->HasWaiters(1));
+    REQUIRE_FALSE(filters->HasWaiters(0));
+
+    // Other consumers are still woken
+    std::thread producer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        filters->WriterEvaluate(Message{1});
+    });
+    REQUIRE(filters->ConsumerWaitDirty(0, std::chrono::seconds{10}));
+    producer.join();
+    REQUIRE_FALSE(filters->HasWaiters(0));
+
+    // Restarted consumer clears the wait of the killed one
+    filters->ConsumerReset(1);
+    REQUIRE_FALSE(filters->HasWaiters(1));
+
+    filters->~ChangeFilters();
+    munmap(memory, sizeof(ChangeFilters));
+}
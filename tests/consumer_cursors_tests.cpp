@@ -0,0 +1,97 @@
+#include <consumer.h>
+#include <consumer_cursors.h>
+#include <producer.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Remover {
+    explicit Remover(const std::string& name) : name(name) {
+        bipc::shared_memory_object::remove(name.c_str());
+    }
+    ~Remover() {
+        bipc::shared_memory_object::remove(name.c_str());
+    }
+    std::string name;
+};
+
+const std::string kChannelName = Configuration::shared_obj_name_prefix + "_test_cursors";
+// Calibration of the tests, so they don't replace the calibration of the machine
+const std::string kTuningName = Configuration::shared_obj_name_prefix + "_test_tuning";
+
+}  // namespace
+
+TEST_CASE("Cursor moves only forward") {
+    ConsumerCursors cursors;
+    REQUIRE(cursors.ConsumerCommitted(0) == 0);
+    cursors.ConsumerCommit(0, 5);
+    REQUIRE(cursors.ConsumerCommitted(0) == 5);
+    cursors.ConsumerCommit(0, 3);
+    REQUIRE(cursors.ConsumerCommitted(0) == 5);
+
+    // Cursors of consumers are independent
+    REQUIRE(cursors.ConsumerCommitted(1) == 0);
+}
+
+TEST_CASE("Concurrent commits keep the greatest generation") {
+    ConsumerCursors cursors;
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < 4; t++) {
+        threads.emplace_back([&cursors, t]() {
+            for (uint64_t i = t; i < 10'000; i += 4) {
+                cursors.ConsumerCommit(0, i);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(cursors.ConsumerCommitted(0) == 9'999);
+}
+
+TEST_CASE("Restarted consumer resumes from the committed generation") {
+    Remover remover(kChannelName);
+    Producer producer(kChannelName, ContainerStrategy::BitmaskCas);
+    producer.UpdateMessage(Message{1});
+    producer.UpdateMessage(Message{2});
+    {
+        Consumer consumer(0, kChannelName);
+        REQUIRE(consumer.CommittedGeneration() == 0);
+        consumer.Commit(consumer.Generation());
+    }
+
+    Consumer restarted(0, kChannelName);
+    REQUIRE(restarted.CommittedGeneration() == 2);
+    REQUIRE(restarted.Generation() == restarted.CommittedGeneration());
+    producer.UpdateMessage(Message{3});
+    REQUIRE(restarted.Generation() > restarted.CommittedGeneration());
+
+    // Other consumer processes have their own cursors
+    Consumer other(1, kChannelName);
+    REQUIRE(other.CommittedGeneration() == 0);
+}
+
+TEST_CASE("Message processed before retune is not processed again after restart") {
+    Remover remover(kChannelName);
+    Remover tuning_remover(kTuningName);
+    {
+        Producer producer(kChannelName, ContainerStrategy::BitmaskCas);
+        producer.UpdateMessage(Message{1});
+        Consumer consumer(0, kChannelName);
+        consumer.Commit(consumer.Generation());
+    }
+    // Producer restarts with another strategy, then with a new calibration
+    {
+        Producer producer(kChannelName, ContainerStrategy::InlineAtomic, kTuningName);
+        producer.Tune();
+    }
+    Producer producer(kChannelName, ContainerStrategy::Unset, kTuningName);
+    Consumer restarted(0, kChannelName);
+    REQUIRE(restarted.Generation() == restarted.CommittedGeneration());
+
+    producer.UpdateMessage(Message{2});
+    REQUIRE(restarted.Generation() == restarted.CommittedGeneration() + 1);
+}
@@ -0,0 +1,240 @@
+#include <auto_tuner.h>
+#include <consumer.h>
+#include <inline_atomic_container.h>
+#include <producer.h>
+#include <seqlock_container.h>
+#include <tuning_cache.h>
+
+#include "seqlock_container_test_access.h"
+
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// Channel in shared memory with a name which doesn't clash with running processes
+struct Remover {
+    explicit Remover(const std::string& name) : name(name) {
+        bipc::shared_memory_object::remove(name.c_str());
+    }
+    ~Remover() {
+        bipc::shared_memory_object::remove(name.c_str());
+    }
+    std::string name;
+};
+
+const std::string kChannelName = Configuration::shared_obj_name_prefix + "_test_strategy";
+// Calibration of the tests, so they don't replace the calibration of the machine
+const std::string kTuningName = Configuration::shared_obj_name_prefix + "_test_tuning";
+
+// Reading thread gets a reader thread index, see ReaderThreadIndex. Read in a separate thread,
+// so the index is released after the test.
+template <class Function>
+void RunReader(Function function) {
+    std::thread(function).join();
+}
+
+// Writer publishes messages equal to their generations, readers check that they never see a
+// message of another generation
+template <class Container>
+void CheckConsistentReads() {
+    Container container;
+    std::atomic<bool> stop{false};
+    std::atomic<int> mismatches{0};
+    std::thread reader([&]() {
+        Message msg;
+        uint64_t generation;
+        while (!stop) {
+            if (container.ReaderRead(msg, generation) && msg.val != generation) {
+                mismatches++;
+            }
+        }
+    });
+    for (uint64_t i = 1; i <= 100'000; i++) {
+        container.WriterUpdateMessage(Message{i}, i);
+    }
+    stop = true;
+    reader.join();
+    REQUIRE(mismatches == 0);
+}
+
+}  // namespace
+
+TEST_CASE("Seqlock container reads the most recent message") {
+    SeqlockContainer container;
+    Message msg;
+    uint64_t generation;
+    REQUIRE(container.IsEmpty());
+    REQUIRE_FALSE(container.ReaderRead(msg, generation));
+
+    container.WriterUpdateMessage(Message{10});
+    container.WriterUpdateMessage(Message{20});
+    REQUIRE(container.ReaderRead(msg, generation));
+    REQUIRE(msg.val == 20);
+    REQUIRE(generation == 2);
+    REQUIRE(container.Generation() == 2);
+    REQUIRE(container.WriterCurrentMessage()->val == 20);
+}
+
+TEST_CASE("Seqlock slot written during a crash stays invalid until it is rewritten") {
+    SeqlockContainer container;
+    container.WriterUpdateMessage(Message{10});
+    container.WriterUpdateMessage(Message{20});
+    int crashed = SeqlockContainerTestAccess::AbandonWrite(container, Message{30});
+
+    // Restarted writer
+    container.WriterReset();
+    // Reader which loaded the index of the slot before the crash doesn't accept its message
+    REQUIRE_FALSE(SeqlockContainerTestAccess::SlotIsValid(container, crashed));
+    Message msg;
+    uint64_t generation;
+    REQUIRE(container.ReaderRead(msg, generation));
+    REQUIRE(msg.val == 20);
+    REQUIRE(generation == 2);
+
+    container.WriterUpdateMessage(Message{40});
+    REQUIRE(SeqlockContainerTestAccess::SlotIsValid(container, crashed));
+    REQUIRE(container.ReaderRead(msg, generation));
+    REQUIRE(msg.val == 40);
+    REQUIRE(generation == 3);
+    container.WriterUpdateMessage(Message{50});
+    REQUIRE(container.ReaderRead(msg, generation));
+    REQUIRE(msg.val == 50);
+    REQUIRE(generation == 4);
+}
+
+TEST_CASE("Seqlock container never returns torn messages") {
+    CheckConsistentReads<SeqlockContainer>();
+}
+
+TEST_CASE("Inline atomic container reads the most recent message") {
+    InlineAtomicContainer container;
+    Message msg;
+    uint64_t generation;
+    REQUIRE_FALSE(container.ReaderRead(msg, generation));
+
+    container.WriterUpdateMessage(Message{7});
+    REQUIRE(container.ReaderRead(msg, generation));
+    REQUIRE(msg.val == 7);
+    REQUIRE(generation == 1);
+}
+
+TEST_CASE("Inline atomic container never returns a message with another generation") {
+    CheckConsistentReads<InlineAtomicContainer>();
+}
+
+TEST_CASE("Calibration measures every strategy") {
+    TuningReport report = AutoTuner::Calibrate(std::chrono::microseconds{200});
+    REQUIRE(report.strategy != ContainerStrategy::Unset);
+    for (uint32_t cost : report.cost_ns) {
+        REQUIRE(cost > 0);
+        REQUIRE(cost >= report.cost_ns[AutoTuner::Index(report.strategy)]);
+    }
+}
+
+TEST_CASE("Machine is calibrated once for all channels") {
+    Remover remover(kTuningName);
+    TuningReport first = TuningCache(kTuningName).Report();
+    REQUIRE(first.strategy != ContainerStrategy::Unset);
+    // Cached report is returned without calibration
+    TuningReport second = TuningCache(kTuningName).Report();
+    REQUIRE(second.strategy == first.strategy);
+    for (int i = 0; i < kContainerStrategiesCount; i++) {
+        REQUIRE(second.cost_ns[i] == first.cost_ns[i]);
+    }
+}
+
+TEST_CASE("Calibration of a killed process is taken over") {
+    Remover remover(kTuningName);
+    pid_t child = fork();
+    if (child == 0) {
+        _exit(0);
+    }
+    REQUIRE(waitpid(child, nullptr, 0) == child);
+    {
+        // Child was killed in the middle of the calibration
+        SharedSegment<TuningSegment> segment(kTuningName);
+        segment->state = (uint64_t(child) << 32) | 1;
+    }
+    TuningReport report = TuningCache(kTuningName).Report();
+    REQUIRE(report.strategy != ContainerStrategy::Unset);
+}
+
+TEST_CASE("Channel is tuned on the first start and keeps the strategy after restart") {
+    Remover remover(kChannelName);
+    Remover tuning_remover(kTuningName);
+    ContainerStrategy strategy;
+    uint32_t cost;
+    {
+        Producer producer(kChannelName, ContainerStrategy::Unset, kTuningName);
+        strategy = producer.Strategy();
+        REQUIRE(strategy != ContainerStrategy::Unset);
+        cost = producer.Settings().cost_ns[AutoTuner::Index(strategy)];
+        REQUIRE(cost != 0);
+        producer.UpdateMessage(Message{5});
+    }
+    Producer producer(kChannelName, ContainerStrategy::Unset, kTuningName);
+    REQUIRE(producer.Strategy() == strategy);
+    REQUIRE(producer.Settings().cost_ns[AutoTuner::Index(strategy)] == cost);
+
+    Consumer consumer(0, kChannelName);
+    REQUIRE(consumer.Strategy() == strategy);
+    RunReader([&]() {
+        Message msg;
+        REQUIRE(consumer.ReadMessage(msg));
+        REQUIRE(msg.val == 5);
+    });
+}
+
+TEST_CASE("Consumer reads channels of every strategy") {
+    for (ContainerStrategy strategy : kContainerStrategies) {
+        Remover remover(kChannelName);
+        Producer producer(kChannelName, strategy);
+        Consumer consumer(0, kChannelName);
+        REQUIRE(consumer.Strategy() == strategy);
+        REQUIRE_FALSE(consumer.HasMessage());
+
+        producer.UpdateMessage(Message{1});
+        producer.UpdateMessage(Message{2});
+        RunReader([&]() {
+            Message msg;
+            uint64_t generation = 0;
+            REQUIRE(consumer.ReadMessage(msg, &generation));
+            REQUIRE(msg.val == 2);
+            REQUIRE(generation == 2);
+            REQUIRE(consumer.Generation() == 2);
+        });
+    }
+}
+
+TEST_CASE("Messages are locked only in channels with bitmask strategy") {
+    Remover remover(kChannelName);
+    Producer producer(kChannelName, ContainerStrategy::Seqlock);
+    Consumer consumer(0, kChannelName);
+    producer.UpdateMessage(Message{1});
+    RunReader([&]() { REQUIRE_THROWS(consumer.LockMessage()); });
+}
+
+TEST_CASE("Switching strategy keeps the most recent message") {
+    Remover remover(kChannelName);
+    {
+        Producer producer(kChannelName, ContainerStrategy::BitmaskCas);
+        producer.UpdateMessage(Message{42});
+    }
+    Producer producer(kChannelName, ContainerStrategy::InlineAtomic);
+    Consumer consumer(0, kChannelName);
+    RunReader([&]() {
+        Message msg;
+        uint64_t generation = 0;
+        REQUIRE(consumer.ReadMessage(msg, &generation));
+        REQUIRE(msg.val == 42);
+        // Moved message is the same message with the same generation
+        REQUIRE(generation == 1);
+    });
+
+    producer.UpdateMessage(Message{43});
+    REQUIRE(consumer.Generation() == 2);
+}
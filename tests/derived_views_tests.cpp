@@ -0,0 +1,106 @@
+#include <derived_views.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+
+// Channels are created in shared memory with names which don't clash with running processes
+struct TestChannel {
+    explicit TestChannel(const std::string& name)
+        : sh_name(Configuration::shared_obj_name_prefix + "_test_" + name),
+          remover(sh_name),
+          producer(sh_name, ContainerStrategy::BitmaskCas),
+          consumer(0, sh_name) {}
+
+    struct Remover {
+        explicit Remover(const std::string& name) : name(name) {
+            bipc::shared_memory_object::remove(name.c_str());
+        }
+        ~Remover() {
+            bipc::shared_memory_object::remove(name.c_str());
+        }
+        std::string name;
+    };
+
+    std::string sh_name;
+    Remover remover;
+    Producer producer;
+    Consumer consumer;
+};
+
+// Reading thread gets a reader thread index, see ReaderThreadIndex. Read in a separate thread,
+// so the index is released after the test.
+template <class Function>
+static void RunReader(Function function) {
+    std::thread(function).join();
+}
+
+static double Sum(const double* values, int count) {
+    double sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+TEST_CASE("Only nodes downstream of changed channel are recomputed") {
+    TestChannel a("a"), b("b"), c("c");
+    DerivedViews views;
+    auto in_a = views.AddInput(a.consumer);
+    auto in_b = views.AddInput(b.consumer);
+    auto in_c = views.AddInput(c.consumer);
+    auto ab = views.AddNode({in_a, in_b}, Sum);
+    auto abc = views.AddNode({ab, in_c}, Sum);
+    int recomputed;
+
+    // Nothing is computed until all channels have messages
+    a.producer.UpdateMessage(Message{1});
+    b.producer.UpdateMessage(Message{2});
+    RunReader([&]() { recomputed = views.Update(); });
+    REQUIRE(recomputed == 3);
+    REQUIRE(views.Value(ab) == 3);
+    REQUIRE(views.Version(abc) == 0);
+
+    c.producer.UpdateMessage(Message{10});
+    RunReader([&]() { recomputed = views.Update(); });
+    REQUIRE(recomputed == 2);
+    REQUIRE(views.Value(abc) == 13);
+
+    // Nothing changed
+    RunReader([&]() { recomputed = views.Update(); });
+    REQUIRE(recomputed == 0);
+
+    c.producer.UpdateMessage(Message{20});
+    RunReader([&]() { recomputed = views.Update(); });
+    REQUIRE(recomputed == 2);
+    REQUIRE(views.Version(ab) == 1);
+    REQUIRE(views.Value(abc) == 23);
+
+    a.producer.UpdateMessage(Message{5});
+    RunReader([&]() { recomputed = views.Update(); });
+    REQUIRE(recomputed == 3);
+    REQUIRE(views.Value(abc) == 27);
+}
+
+TEST_CASE("Node is published to derived channel") {
+    TestChannel a("publish_input");
+    const std::string name = "test_sum";
+    TestChannel::Remover remover(DerivedChannelName(name));
+    DerivedViews views;
+    auto in_a = views.AddInput(a.consumer);
+    auto doubled = views.AddNode({in_a}, [](const double* values, int) { return values[0] * 2; });
+    views.Publish(doubled, name, 0, ContainerStrategy::BitmaskCas);
+    // Process which publishes the channel doesn't read it
+    REQUIRE_THROWS(Consumer(0, DerivedChannelName(name)));
+
+    // Another process reads it
+    Consumer derived(1, DerivedChannelName(name));
+    DerivedViews derived_views;
+    auto derived_in = derived_views.AddInput(derived, DerivedViews::InputFormat::Double);
+
+    a.producer.UpdateMessage(Message{21});
+    RunReader([&]() {
+        views.Update();
+        derived_views.Update();
+    });
+    REQUIRE(derived_views.Value(derived_in) == 42);
+}
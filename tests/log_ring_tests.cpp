@@ -0,0 +1,102 @@
+#include <log_ring.h>
+
+#include "mpsc_queue_test_access.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <stdio.h>
+#include <string>
+
+// Log in shared memory with the name which doesn't clash with running processes
+struct TestLog {
+    TestLog() : file(tmpfile()) {
+        bipc::shared_memory_object::remove(name.c_str());
+    }
+    ~TestLog() {
+        fclose(file);
+        bipc::shared_memory_object::remove(name.c_str());
+    }
+
+    std::string Output() {
+        std::string output;
+        rewind(file);
+        char buf[4096];
+        size_t size;
+        while ((size = fread(buf, 1, sizeof(buf), file)) > 0) {
+            output.append(buf, size);
+        }
+        return output;
+    }
+
+    const std::string name = Configuration::shared_obj_name_prefix + "_test_log";
+    FILE* file;
+};
+
+TEST_CASE("Records are formatted by the logger") {
+    TestLog log;
+    LogWriter writer0(0, log.name);
+    LogWriter writer1(1, log.name);
+    writer0.Log(LogEvent::Ready);
+    writer1.Log(LogEvent::Read, 0, 42);
+    writer1.Log(LogEvent::ReadEmpty, 2);
+    writer0.Log(LogEvent::Write, 0, 7);
+    {
+        LogCollector collector(fileno(log.file), log.name);
+        REQUIRE(collector.Drain() == 4);
+        REQUIRE(collector.Drain() == 0);
+    }
+    REQUIRE(log.Output() ==
+            "0: ready\n"
+            "1: read info from 0: 42\n"
+            "1: read info from 2: empty\n"
+            "0: write 7\n");
+}
+
+TEST_CASE("Dropped records are reported") {
+    TestLog log;
+    LogWriter writer(0, log.name);
+    LogCollector collector(fileno(log.file), log.name);
+    writer.Log(LogEvent::Write, 0, 1);
+    collector.Drain();
+
+    // Records which don't fit in the queue are dropped
+    const unsigned fit = Configuration::log_capacity - Configuration::number_of_processes + 1;
+    for (unsigned i = 0; i < fit + 10; i++) {
+        writer.Log(LogEvent::Write, 0, 2);
+    }
+    while (collector.Drain() != 0) {
+    }
+    writer.Log(LogEvent::Write, 0, 3);
+    collector.Drain();
+
+    std::string output = log.Output();
+    REQUIRE(output.find("0: 10 log records lost\n0: write 3\n") != std::string::npos);
+}
+
+TEST_CASE("Record of a writer killed mid-append is skipped") {
+    TestLog log;
+    LogCollector collector(fileno(log.file), log.name);
+    {
+        LogWriter writer0(0, log.name);
+        LogWriter writer1(1, log.name);
+        writer1.Log(LogEvent::Write, 0, 1);
+        // Writer 1 is killed after it took a sequence number and claimed an entry
+        SharedSegment<LogSegment> segment(log.name);
+        segment->next_sequence[1]++;
+        MpscQueueTestAccess::AbandonPush(segment->queue, 1, true);
+        writer0.Log(LogEvent::Write, 0, 2);
+        // Logger waits for the unfinished record
+        REQUIRE(collector.Drain() == 1);
+        REQUIRE(collector.Drain() == 0);
+    }
+
+    // Restarted writer abandons the record, the logger skips it and keeps going
+    LogWriter writer1(1, log.name);
+    writer1.Log(LogEvent::Write, 0, 3);
+    REQUIRE(collector.Drain() == 2);
+    REQUIRE(log.Output() ==
+            "1: write 1\n"
+            "0: write 2\n"
+            "1: 1 log records lost\n"
+            "1: write 3\n");
+}
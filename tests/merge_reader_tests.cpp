@@ -0,0 +1,70 @@
+#include <merge_reader.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+static std::vector<uint64_t> Values(const std::vector<MergedMessage>& batch) {
+    std::vector<uint64_t> values;
+    for (const MergedMessage& msg : batch) {
+        values.push_back(msg.entry.message.val);
+    }
+    return values;
+}
+
+TEST_CASE("Merge by timestamp when all producers have messages") {
+    MessageHistory history0, history1;
+    MergeReader reader({{0, &history0}, {1, &history1}}, std::chrono::nanoseconds{1000}, 16);
+
+    history0.WriterAppend(10, Message{1});
+    history1.WriterAppend(20, Message{2});
+    history0.WriterAppend(30, Message{3});
+    history1.WriterAppend(40, Message{4});
+    history0.WriterAppend(50, Message{5});
+
+    // The last message waits for producer 1, which can still publish an older message
+    const auto& batch = reader.Poll(60);
+    REQUIRE(Values(batch) == std::vector<uint64_t>{1, 2, 3, 4});
+    REQUIRE(batch[1].producer_index == 1);
+
+    history1.WriterAppend(60, Message{6});
+    REQUIRE(Values(reader.Poll(70)) == std::vector<uint64_t>{5});
+}
+
+TEST_CASE("Silent producer delays messages not longer than lateness") {
+    MessageHistory history0, history1;
+    MergeReader reader({{0, &history0}, {1, &history1}}, std::chrono::nanoseconds{100}, 16);
+
+    history0.WriterAppend(10, Message{1});
+    history0.WriterAppend(20, Message{2});
+    REQUIRE(reader.Poll(50).empty());
+    REQUIRE(Values(reader.Poll(115)) == std::vector<uint64_t>{1});
+    REQUIRE(Values(reader.Poll(200)) == std::vector<uint64_t>{2});
+
+    // Message published too late is delivered out of order
+    history1.WriterAppend(15, Message{3});
+    REQUIRE(Values(reader.Poll(300)) == std::vector<uint64_t>{3});
+    REQUIRE(reader.LateCount() == 1);
+}
+
+TEST_CASE("Batch size is limited") {
+    MessageHistory history;
+    MergeReader reader({{0, &history}}, std::chrono::nanoseconds{0}, 2);
+    for (uint64_t i = 1; i <= 5; i++) {
+        history.WriterAppend(i, Message{i});
+    }
+    REQUIRE(Values(reader.Poll(10)) == std::vector<uint64_t>{1, 2});
+    REQUIRE(Values(reader.Poll(10)) == std::vector<uint64_t>{3, 4});
+    REQUIRE(Values(reader.Poll(10)) == std::vector<uint64_t>{5});
+}
+
+TEST_CASE("Overwritten messages are counted as lost") {
+    MessageHistory history;
+    MergeReader reader({{0, &history}}, std::chrono::nanoseconds{0}, 1000);
+    const uint64_t count = Configuration::history_length + 3;
+    for (uint64_t i = 1; i <= count; i++) {
+        history.WriterAppend(i, Message{i});
+    }
+    const auto& batch = reader.Poll(count);
+    REQUIRE(batch.size() == Configuration::history_length);
+    REQUIRE(batch.front().entry.message.val == 4);
+    REQUIRE(reader.LostCount() == 3);
+}
@@ -0,0 +1,40 @@
+#include <message_history.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("Empty history") {
+    MessageHistory history;
+    HistoryEntry entry;
+    REQUIRE(history.LastGeneration() == 0);
+    REQUIRE_FALSE(history.ReaderGet(1, entry));
+}
+
+TEST_CASE("Read appended messages") {
+    MessageHistory history;
+    REQUIRE(history.WriterAppend(100, Message{10}) == 1);
+    REQUIRE(history.WriterAppend(200, Message{20}) == 2);
+
+    HistoryEntry entry;
+    REQUIRE(history.ReaderGet(1, entry));
+    REQUIRE(entry.generation == 1);
+    REQUIRE(entry.timestamp_ns == 100);
+    REQUIRE(entry.message.val == 10);
+    REQUIRE(history.ReaderGet(2, entry));
+    REQUIRE(entry.message.val == 20);
+    REQUIRE_FALSE(history.ReaderGet(3, entry));
+}
+
+TEST_CASE("Overwritten messages are not readable") {
+    MessageHistory history;
+    const uint64_t count = Configuration::history_length + 5;
+    for (uint64_t i = 1; i <= count; i++) {
+        history.WriterAppend(i, Message{i});
+    }
+    REQUIRE(history.FirstGeneration() == 6);
+
+    HistoryEntry entry;
+    REQUIRE_FALSE(history.ReaderGet(5, entry));
+    REQUIRE(history.ReaderGet(6, entry));
+    REQUIRE(entry.message.val == 6);
+    REQUIRE(history.ReaderGet(count, entry));
+}
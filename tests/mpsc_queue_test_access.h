@@ -0,0 +1,20 @@
+#ifndef _MPSC_QUEUE_TEST_ACCESS_H_
+#define _MPSC_QUEUE_TEST_ACCESS_H_
+
+#include <mpsc_queue.h>
+
+// Stops a push half-way, as if the producer was killed
+struct MpscQueueTestAccess {
+    // Reserves a position, and claims its entry if `claim` is true, but never commits it
+    template <class T, unsigned Capacity>
+    static void AbandonPush(MpscQueue<T, Capacity>& queue, int producer_index, bool claim) {
+        using Queue = MpscQueue<T, Capacity>;
+        uint64_t pos = queue.tail_.fetch_add(1);
+        if (claim) {
+            queue.entries_[pos % Capacity].state =
+                Queue::MakeState(pos / Capacity, producer_index, Queue::kWriting);
+        }
+    }
+};
+
+#endif
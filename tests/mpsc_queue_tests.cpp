@@ -0,0 +1,166 @@
+#include <mpsc_queue.h>
+
+#include "mpsc_queue_test_access.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <new>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using Queue = MpscQueue<uint64_t, 64>;
+
+// Queue is too big for the stack in some configurations, value initialization zeroes it
+// the same way as shared memory does.
+static std::unique_ptr<Queue> MakeQueue() {
+    return std::make_unique<Queue>();
+}
+
+TEST_CASE("Queue drains in push order") {
+    auto queue = MakeQueue();
+    REQUIRE(queue->IsEmpty());
+    REQUIRE(queue->TryPush(0, 10));
+    REQUIRE(queue->TryPush(1, 20));
+    REQUIRE(queue->TryPush(0, 30));
+
+    std::vector<std::pair<int, uint64_t>> drained;
+    auto handler = [&](int producer, uint64_t value) { drained.emplace_back(producer, value); };
+    REQUIRE(queue->CollectorDrain(handler, 2) == 2);
+    REQUIRE(queue->CollectorDrain(handler, 10) == 1);
+    REQUIRE(queue->IsEmpty());
+    REQUIRE(drained == std::vector<std::pair<int, uint64_t>>{{0, 10}, {1, 20}, {0, 30}});
+}
+
+TEST_CASE("Push to full queue fails") {
+    auto queue = MakeQueue();
+    uint64_t pushed = 0;
+    while (queue->TryPush(0, pushed)) {
+        pushed++;
+    }
+    // Room is left for producers racing between the fullness check and the reservation
+    REQUIRE(pushed == 64 - Configuration::number_of_processes + 1);
+
+    // Draining frees entries for the next lap
+    uint64_t expected = 0;
+    queue->CollectorDrain([&](int, uint64_t value) { REQUIRE(value == expected++); }, 64);
+    REQUIRE(expected == pushed);
+    for (uint64_t i = 0; i < pushed; i++) {
+        REQUIRE(queue->TryPush(0, i));
+    }
+}
+
+TEST_CASE("Several producers don't lose values") {
+    auto queue = MakeQueue();
+    const int producers = Configuration::number_of_processes;
+    const uint64_t per_producer = 1000;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p]() {
+            for (uint64_t i = 0; i < per_producer;) {
+                if (queue->TryPush(p, i)) {
+                    i++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Values of a single producer come in order
+    std::vector<uint64_t> next(producers, 0);
+    uint64_t total = 0;
+    while (total < producers * per_producer) {
+        total += queue->CollectorDrain(
+            [&](int producer, uint64_t value) { REQUIRE(value == next[producer]++); }, 16);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(queue->IsEmpty());
+}
+
+TEST_CASE("Push doesn't fail while the collector drains concurrently") {
+    auto queue = MakeQueue();
+    std::atomic<bool> stop{false};
+    std::thread collector([&]() {
+        while (!stop) {
+            queue->CollectorDrain([](int, uint64_t) {}, 64);
+        }
+    });
+    // Queue never holds more than a single value, so it is never full
+    for (uint64_t i = 0; i < 1000; i++) {
+        REQUIRE(queue->TryPush(0, i));
+        while (!queue->IsEmpty()) {
+            std::this_thread::yield();
+        }
+    }
+    stop = true;
+    collector.join();
+}
+
+TEST_CASE("Restarted producer abandons its unfinished entry") {
+    auto queue = MakeQueue();
+    queue->WriterReset(1);
+    MpscQueueTestAccess::AbandonPush(*queue, 1, true);
+    REQUIRE(queue->TryPush(0, 10));
+    std::vector<uint64_t> drained;
+    auto handler = [&](int, uint64_t value) { drained.push_back(value); };
+    // Collector waits for the unfinished entry
+    REQUIRE(queue->CollectorDrain(handler, 10) == 0);
+
+    queue->WriterReset(1);
+    REQUIRE(queue->CollectorDrain(handler, 10) == 1);
+    REQUIRE(drained == std::vector<uint64_t>{10});
+    REQUIRE(queue->IsEmpty());
+}
+
+TEST_CASE("Reserved but not claimed entry is skipped after timeout") {
+    auto queue = MakeQueue();
+    MpscQueueTestAccess::AbandonPush(*queue, 1, false);
+    REQUIRE(queue->TryPush(0, 10));
+    const auto timeout = std::chrono::milliseconds{1};
+    auto handler = [](int, uint64_t value) { REQUIRE(value == 10); };
+    REQUIRE(queue->CollectorDrain(handler, 10, timeout) == 0);
+    std::this_thread::sleep_for(2 * timeout);
+    REQUIRE(queue->CollectorDrain(handler, 10, timeout) == 1);
+    REQUIRE(queue->IsEmpty());
+}
+
+TEST_CASE("Entry of dead producer is skipped, entry of alive producer is not") {
+    // Queue is shared with a child process, which dies in the middle of a push
+    void* memory = mmap(nullptr, sizeof(Queue), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    REQUIRE(memory != MAP_FAILED);
+    Queue* queue = new (memory) Queue();
+    pid_t child = fork();
+    if (child == 0) {
+        queue->WriterReset(1);
+        MpscQueueTestAccess::AbandonPush(*queue, 1, true);
+        _exit(0);
+    }
+    REQUIRE(waitpid(child, nullptr, 0) == child);
+    REQUIRE(queue->TryPush(0, 10));
+
+    const auto timeout = std::chrono::milliseconds{1};
+    std::vector<uint64_t> drained;
+    auto handler = [&](int, uint64_t value) { drained.push_back(value); };
+    REQUIRE(queue->CollectorDrain(handler, 10, timeout) == 0);
+    std::this_thread::sleep_for(2 * timeout);
+    REQUIRE(queue->CollectorDrain(handler, 10, timeout) == 1);
+    REQUIRE(drained == std::vector<uint64_t>{10});
+
+    // This process is alive, its unfinished entry is waited for
+    queue->WriterReset(2);
+    MpscQueueTestAccess::AbandonPush(*queue, 2, true);
+    REQUIRE(queue->TryPush(0, 20));
+    REQUIRE(queue->CollectorDrain(handler, 10, timeout) == 0);
+    std::this_thread::sleep_for(2 * timeout);
+    REQUIRE(queue->CollectorDrain(handler, 10, timeout) == 0);
+    REQUIRE(drained.size() == 1);
+
+    queue->~Queue();
+    munmap(memory, sizeof(Queue));
+}
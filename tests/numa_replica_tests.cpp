@@ -0,0 +1,154 @@
+#include <consumer.h>
+#include <numa.h>
+#include <numa_replica.h>
+#include <producer.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+
+namespace {
+
+struct Remover {
+    explicit Remover(const std::string& name) : name(name) {
+        bipc::shared_memory_object::remove(name.c_str());
+    }
+    ~Remover() {
+        bipc::shared_memory_object::remove(name.c_str());
+    }
+    std::string name;
+};
+
+const std::string kChannelName = Configuration::shared_obj_name_prefix + "_test_replica";
+
+uint64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Reading thread gets a reader thread index, see ReaderThreadIndex. Read in a separate thread,
+// so the index is released after the test.
+uint64_t ReadValue(Consumer& consumer) {
+    uint64_t value = 0;
+    std::thread([&]() {
+        Message msg;
+        REQUIRE(consumer.ReadMessage(msg));
+        value = msg.val;
+    }).join();
+    return value;
+}
+
+}  // namespace
+
+TEST_CASE("Sysfs lists are parsed") {
+    REQUIRE(ParseSysfsList("0-3,8,10-11\n") == std::vector<int>{0, 1, 2, 3, 8, 10, 11});
+    REQUIRE(ParseSysfsList("0") == std::vector<int>{0});
+    REQUIRE(ParseSysfsList("").empty());
+}
+
+TEST_CASE("Current node is one of online nodes") {
+    std::vector<int> nodes = NumaNodes();
+    REQUIRE(std::find(nodes.begin(), nodes.end(), CurrentNumaNode()) != nodes.end());
+}
+
+TEST_CASE("Relay copies only changed messages with their generations") {
+    Remover channel_remover(kChannelName);
+    Remover replica_remover(ReplicaName(kChannelName, 0));
+    Producer producer(kChannelName, ContainerStrategy::BitmaskCas);
+    ReplicaRelay relay(kChannelName, 0);
+    SharedSegment<ReplicaSegment> replica(ReplicaName(kChannelName, 0));
+
+    REQUIRE_FALSE(relay.Poll());
+    producer.UpdateMessage(Message{1});
+    producer.UpdateMessage(Message{2});
+    REQUIRE(relay.Poll());
+    REQUIRE_FALSE(relay.Poll());
+
+    Message msg;
+    uint64_t generation;
+    REQUIRE(replica->container.ReaderRead(msg, generation));
+    REQUIRE(msg.val == 2);
+    REQUIRE(generation == 2);
+}
+
+TEST_CASE("Consumer reads fresh replica and falls back to the channel") {
+    Remover channel_remover(kChannelName);
+    Remover replica_remover(ReplicaName(kChannelName, 0));
+    Producer producer(kChannelName, ContainerStrategy::BitmaskCas);
+    Consumer consumer(0, kChannelName);
+    REQUIRE_FALSE(consumer.AttachReplica(0));
+
+    ReplicaRelay relay(kChannelName, 0);
+    REQUIRE(consumer.AttachReplica(0));
+    producer.UpdateMessage(Message{1});
+    relay.Poll();
+    producer.UpdateMessage(Message{2});
+
+    // Replica is a bit behind the channel
+    REQUIRE(consumer.ReadsReplica());
+    REQUIRE(ReadValue(consumer) == 1);
+    REQUIRE(consumer.Generation() == 1);
+
+    relay.Poll();
+    REQUIRE(ReadValue(consumer) == 2);
+
+    // Relay stopped refreshing the replica
+    producer.UpdateMessage(Message{3});
+    auto stale = std::chrono::nanoseconds{Configuration::replica_max_staleness} +
+                 std::chrono::seconds{1};
+    relay.Poll(NowNs() - stale.count());
+    REQUIRE_FALSE(consumer.ReadsReplica());
+    REQUIRE(ReadValue(consumer) == 3);
+    REQUIRE(consumer.Generation() == 3);
+}
+
+TEST_CASE("Consumer attaches the replica of its node when the relay starts") {
+    const int node = CurrentNumaNode();
+    Remover channel_remover(kChannelName);
+    Remover replica_remover(ReplicaName(kChannelName, node));
+    Producer producer(kChannelName, ContainerStrategy::BitmaskCas);
+    Consumer consumer(0, kChannelName);
+    consumer.FollowNumaNode();
+    producer.UpdateMessage(Message{1});
+    REQUIRE(ReadValue(consumer) == 1);
+    REQUIRE_FALSE(consumer.ReadsReplica());
+
+    ReplicaRelay relay(kChannelName, node);
+    relay.Poll();
+    std::this_thread::sleep_for(Configuration::replica_attach_period +
+                                std::chrono::milliseconds{10});
+    relay.Poll();
+    REQUIRE(consumer.ReadsReplica());
+    REQUIRE(ReadValue(consumer) == 1);
+}
+
+TEST_CASE("Consumer doesn't go back to an older replica after reading the channel") {
+    Remover channel_remover(kChannelName);
+    Remover replica_remover(ReplicaName(kChannelName, 0));
+    Producer producer(kChannelName, ContainerStrategy::BitmaskCas);
+    Consumer consumer(0, kChannelName);
+    ReplicaRelay relay(kChannelName, 0);
+    SharedSegment<ReplicaSegment> replica(ReplicaName(kChannelName, 0));
+    REQUIRE(consumer.AttachReplica(0));
+
+    // Replica is stale, the channel is read
+    producer.UpdateMessage(Message{1});
+    auto stale = std::chrono::nanoseconds{Configuration::replica_max_staleness} +
+                 std::chrono::seconds{1};
+    relay.Poll(NowNs() - stale.count());
+    producer.UpdateMessage(Message{2});
+    REQUIRE(consumer.Generation() == 2);
+    REQUIRE(ReadValue(consumer) == 2);
+
+    // Replica becomes fresh, but it is still behind the channel
+    replica->refreshed_ns = NowNs();
+    REQUIRE_FALSE(consumer.ReadsReplica());
+    REQUIRE(consumer.Generation() == 2);
+    REQUIRE(ReadValue(consumer) == 2);
+
+    // Replica catches up
+    relay.Poll();
+    REQUIRE(consumer.ReadsReplica());
+    REQUIRE(consumer.Generation() == 2);
+    REQUIRE(ReadValue(consumer) == 2);
+}
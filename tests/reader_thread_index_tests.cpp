@@ -0,0 +1,104 @@
+#include <consumer.h>
+#include <producer.h>
+#include <reader_thread_index.h>
+
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Same index for the same thread") {
+    int first = -1, second = -1;
+    std::thread([&]() {
+        first = ReaderThreadIndex::Get();
+        second = ReaderThreadIndex::Get();
+    }).join();
+    REQUIRE(first == second);
+}
+
+TEST_CASE("Index is released on thread exit") {
+    int first = -1, second = -1;
+    std::thread([&]() { first = ReaderThreadIndex::Get(); }).join();
+    std::thread([&]() { second = ReaderThreadIndex::Get(); }).join();
+    REQUIRE(first == second);
+}
+
+TEST_CASE("Too many reader threads") {
+    const int num = Configuration::reader_threads_per_process;
+    std::atomic<int> started = 0;
+    std::atomic<bool> finish = false;
+    std::vector<int> indices(num, -1);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num; i++) {
+        threads.emplace_back([&, i]() {
+            indices[i] = ReaderThreadIndex::Get();
+            started++;
+            while (!finish) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    while (started != num) {
+        std::this_thread::yield();
+    }
+    // All indices are taken by running threads
+    bool thrown = false;
+    std::thread([&]() {
+        try {
+            ReaderThreadIndex::Get();
+        } catch (std::runtime_error&) {
+            thrown = true;
+        }
+    }).join();
+    REQUIRE(thrown);
+
+    finish = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int i = 0; i < num; i++) {
+        for (int j = i + 1; j < num; j++) {
+            REQUIRE(indices[i] != indices[j]);
+        }
+    }
+}
+
+TEST_CASE("Message locked by an exited thread is unlocked") {
+    const std::string name = Configuration::shared_obj_name_prefix + "_test_thread_exit";
+    bipc::shared_memory_object::remove(name.c_str());
+    {
+        Producer producer(name, ContainerStrategy::BitmaskCas);
+        producer.UpdateMessage(Message{1});
+        Consumer consumer(0, name);
+        // Thread exits without unlocking
+        std::thread([&]() { consumer.LockMessage(); }).join();
+        std::thread([&]() {
+            Message msg;
+            REQUIRE_NOTHROW(consumer.ReadMessage(msg));
+            REQUIRE_NOTHROW(consumer.LockMessage());
+            consumer.UnlockMessage();
+        }).join();
+    }
+    bipc::shared_memory_object::remove(name.c_str());
+}
+
+TEST_CASE("Another consumer of the channel doesn't release locked messages") {
+    const std::string name = Configuration::shared_obj_name_prefix + "_test_second_consumer";
+    bipc::shared_memory_object::remove(name.c_str());
+    {
+        Producer producer(name, ContainerStrategy::BitmaskCas);
+        producer.UpdateMessage(Message{1});
+        Consumer first(0, name);
+        std::thread([&]() {
+            const Message* locked = first.LockMessage();
+            Consumer second(0, name);
+            // Writer would reuse the slot if the lock was released
+            for (uint64_t i = 2; i < 20; i++) {
+                producer.UpdateMessage(Message{i});
+            }
+            REQUIRE(locked->val == 1);
+            first.UnlockMessage();
+        }).join();
+    }
+    bipc::shared_memory_object::remove(name.c_str());
+}
@@ -0,0 +1,45 @@
+#include <rt_mode.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <sys/mman.h>
+
+TEST_CASE("Verifier passes steady state without faults and allocations") {
+    RtVerifier verifier;
+    verifier.Start();
+    volatile uint64_t sum = 0;
+    for (int i = 0; i < 1000; i++) {
+        sum = sum + i;
+    }
+    // Assertions may allocate, so the counters are read before them
+    uint64_t allocations = verifier.Allocations();
+    uint64_t faults = verifier.PageFaults();
+    REQUIRE(allocations == 0);
+    REQUIRE(faults == 0);
+}
+
+TEST_CASE("Verifier counts heap allocations") {
+    RtVerifier verifier;
+    verifier.Start();
+    auto value = std::make_unique<int>(5);
+    uint64_t allocations = verifier.Allocations();
+    REQUIRE(allocations == 1);
+    REQUIRE_THROWS(verifier.Check());
+}
+
+TEST_CASE("Verifier counts page faults") {
+    const size_t kPages = 16;
+    const size_t kSize = kPages * 4096;
+    void* mem = mmap(nullptr, kSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    REQUIRE(mem != MAP_FAILED);
+
+    RtVerifier verifier;
+    verifier.Start();
+    volatile char* bytes = static_cast<char*>(mem);
+    for (size_t i = 0; i < kSize; i += 4096) {
+        bytes[i] = 1;
+    }
+    uint64_t faults = verifier.PageFaults();
+    munmap(mem, kSize);
+    REQUIRE(faults >= kPages);
+}
@@ -0,0 +1,25 @@
+#ifndef _SEQLOCK_CONTAINER_TEST_ACCESS_H_
+#define _SEQLOCK_CONTAINER_TEST_ACCESS_H_
+
+#include <seqlock_container.h>
+
+// Stops a write half-way, as if the writer was killed
+struct SeqlockContainerTestAccess {
+    // Starts writing `msg` to the slot which is not current, but never finishes.
+    // Returns index of the slot.
+    static int AbandonWrite(SeqlockContainer& container, const Message& msg) {
+        int slot_index = 1 - container.current_slot_;
+        SeqlockContainer::Slot& slot = container.slots_[slot_index];
+        slot.seq.store(slot.seq | 1);
+        slot.message = msg;
+        return slot_index;
+    }
+
+    // Returns true if readers which loaded the index of the slot would accept its message
+    static bool SlotIsValid(const SeqlockContainer& container, int slot_index) {
+        uint64_t seq = container.slots_[slot_index].seq;
+        return seq != 0 && (seq & 1) == 0;
+    }
+};
+
+#endif
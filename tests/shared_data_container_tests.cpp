@@ -84,10 +84,102 @@ TEST_CASE("Writes when all readers has a single locked slot") {
 TEST_CASE("Writes when one process locked all slots") {
     SharedDataContainer shd;
     std::vector<int> handles(Configuration::number_of_processes);
-    for (unsigned i = 0; i < Configuration::number_of_processes+1; i++) {
+    const unsigned slots_count =
+        (Configuration::number_of_processes - 1) * Configuration::reader_threads_per_process + 2;
+    for (unsigned i = 0; i < slots_count; i++) {
         shd.WriterUpdateMessage(Message{i * 10});
         shd.ReaderLock(0);
     }
     // No empty slot :(
     REQUIRE_THROWS(shd.WriterUpdateMessage(Message{1}));
 }
+
+TEST_CASE("Locks by several threads of the same process") {
+    SharedDataContainer shd;
+    shd.WriterUpdateMessage(Message{5});
+    const int last_thread = Configuration::reader_threads_per_process - 1;
+    auto handle0 = shd.ReaderLock(SharedDataContainer::ReaderIndex(1, 0));
+    REQUIRE_THROWS(shd.ReaderLock(SharedDataContainer::ReaderIndex(1, 0)));
+    if (last_thread > 0) {
+        auto handle1 = shd.ReaderLock(SharedDataContainer::ReaderIndex(1, last_thread));
+        REQUIRE_NOTHROW(shd.ReaderUnlock(SharedDataContainer::ReaderIndex(1, last_thread), handle1));
+    }
+    REQUIRE_NOTHROW(shd.ReaderUnlock(SharedDataContainer::ReaderIndex(1, 0), handle0));
+}
+
+TEST_CASE("Reset releases locks of all threads of the process") {
+    SharedDataContainer shd;
+    const int last_thread = Configuration::reader_threads_per_process - 1;
+    shd.WriterUpdateMessage(Message{5});
+    shd.ReaderLock(SharedDataContainer::ReaderIndex(1, 0));
+    shd.WriterUpdateMessage(Message{6});
+    shd.ReaderLock(SharedDataContainer::ReaderIndex(1, last_thread));
+    auto other_handle = shd.ReaderLock(SharedDataContainer::ReaderIndex(0, 0));
+
+    shd.ReaderReset(1);
+    REQUIRE_NOTHROW(shd.ReaderLock(SharedDataContainer::ReaderIndex(1, 0)));
+    // Locks of other processes are untouched
+    REQUIRE_NOTHROW(shd.ReaderUnlock(SharedDataContainer::ReaderIndex(0, 0), other_handle));
+}
+
+TEST_CASE("Reset of a single reader keeps locks of other readers") {
+    SharedDataContainer shd;
+    shd.WriterUpdateMessage(Message{5});
+    shd.ReaderLock(1);
+    auto other_handle = shd.ReaderLock(2);
+
+    shd.ReaderResetReader(1);
+    REQUIRE_NOTHROW(shd.ReaderLock(1));
+    REQUIRE_NOTHROW(shd.ReaderUnlock(2, other_handle));
+}
+
+TEST_CASE("Generation is increased by every write") {
+    SharedDataContainer shd;
+    REQUIRE(shd.Generation() == 0);
+    shd.WriterUpdateMessage(Message{10});
+    auto handle1 = shd.ReaderLock(0);
+    shd.WriterUpdateMessage(Message{20});
+    REQUIRE(shd.Generation() == 2);
+    auto handle2 = shd.ReaderLock(1);
+    REQUIRE(shd.ReaderGetGeneration(handle1) == 1);
+    REQUIRE(shd.ReaderGetGeneration(handle2) == 2);
+    shd.WriterReset();
+    REQUIRE(shd.Generation() == 2);
+}
+
+// Reader 1 holds the first slot while two messages are written, then releases it.
+// Returns the slot of the fourth message.
+template <class Container>
+static int SlotAfterReaderRelease() {
+    Container shd;
+    shd.WriterUpdateMessage(Message{1});
+    auto handle = shd.ReaderLock(1);
+    shd.WriterUpdateMessage(Message{2});
+    shd.WriterUpdateMessage(Message{3});
+    shd.ReaderUnlock(1, handle);
+    shd.WriterUpdateMessage(Message{4});
+    auto current = shd.ReaderLock(0);
+    REQUIRE(shd.ReaderGetMessage(current)->val == 4);
+    return current;
+}
+
+TEST_CASE("Writer prefers the slot it freed to the slot freed by reader") {
+    using FirstFreeContainer = BasicSharedDataContainer<Message, SlotPolicy::FirstFree>;
+    using RecentlyFreedContainer = BasicSharedDataContainer<Message, SlotPolicy::RecentlyFreed>;
+    // The first slot was touched by the reader, the second was freed by the writer
+    REQUIRE(SlotAfterReaderRelease<FirstFreeContainer>() == 0);
+    REQUIRE(SlotAfterReaderRelease<RecentlyFreedContainer>() == 1);
+}
+
+TEST_CASE("Writer doesn't reuse recently freed slot while it is locked") {
+    SharedDataContainer shd;
+    shd.WriterUpdateMessage(Message{1});
+    shd.WriterUpdateMessage(Message{2});
+    // Recently freed slot is locked after the next write
+    shd.WriterUpdateMessage(Message{3});
+    auto handle = shd.ReaderLock(1);
+    shd.WriterUpdateMessage(Message{4});
+    shd.WriterPrefetch();
+    shd.WriterUpdateMessage(Message{5});
+    REQUIRE(shd.ReaderGetMessage(handle)->val == 3);
+}
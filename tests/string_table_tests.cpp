@@ -0,0 +1,98 @@
+#include <string_table.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Value initialization zeroes the table the same way as shared memory does
+static std::unique_ptr<StringTable> MakeTable() {
+    return std::make_unique<StringTable>();
+}
+
+TEST_CASE("Same string gets the same id") {
+    auto table = MakeTable();
+    uint32_t foo = table->Intern("foo");
+    uint32_t bar = table->Intern("bar");
+    REQUIRE(foo != bar);
+    REQUIRE(table->Intern("foo") == foo);
+    REQUIRE(table->Find("bar") == bar);
+    REQUIRE(table->Find("baz") == StringTable::kInvalidId);
+}
+
+TEST_CASE("Lookup by id") {
+    auto table = MakeTable();
+    uint32_t id = table->Intern("label");
+    uint32_t empty_id = table->Intern("");
+    std::string_view str;
+    REQUIRE(table->Lookup(id, str));
+    REQUIRE(str == "label");
+    REQUIRE(table->Lookup(empty_id, str));
+    REQUIRE(str.empty());
+    REQUIRE_FALSE(table->Lookup(empty_id + 1, str));
+    REQUIRE_FALSE(table->Lookup(StringTable::kInvalidId, str));
+}
+
+TEST_CASE("Full table") {
+    auto table = MakeTable();
+    for (unsigned i = 0; i < Configuration::string_table_capacity; i++) {
+        table->Intern(std::to_string(i));
+    }
+    REQUIRE_THROWS(table->Intern("one more"));
+    // Existing strings are still found
+    REQUIRE(table->Intern("0") == table->Find("0"));
+}
+
+TEST_CASE("Inserts into the full table don't overwrite existing strings") {
+    auto table = MakeTable();
+    // Fill the arena with long strings
+    const std::string filler(1000, 'x');
+    std::vector<uint32_t> ids;
+    try {
+        while (true) {
+            ids.push_back(table->Intern(filler + std::to_string(ids.size())));
+        }
+    } catch (std::runtime_error&) {}
+    REQUIRE(!ids.empty());
+
+    for (int i = 0; i < 10'000; i++) {
+        REQUIRE_THROWS(table->Intern(filler + "more" + std::to_string(i)));
+    }
+    // Short string fits in the rest of the arena
+    uint32_t short_id = table->Intern("short");
+    for (size_t i = 0; i < ids.size(); i++) {
+        std::string_view str;
+        REQUIRE(table->Lookup(ids[i], str));
+        REQUIRE(str == filler + std::to_string(i));
+    }
+    std::string_view str;
+    REQUIRE(table->Lookup(short_id, str));
+    REQUIRE(str == "short");
+}
+
+TEST_CASE("Concurrent inserts of the same strings") {
+    auto table = MakeTable();
+    const int threads_count = 4;
+    const int strings_count = 500;
+    std::vector<std::vector<uint32_t>> ids(threads_count, std::vector<uint32_t>(strings_count));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threads_count; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < strings_count; i++) {
+                ids[t][i] = table->Intern("key" + std::to_string(i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int i = 0; i < strings_count; i++) {
+        std::string_view str;
+        REQUIRE(table->Lookup(ids[0][i], str));
+        REQUIRE(str == "key" + std::to_string(i));
+        for (int t = 1; t < threads_count; t++) {
+            REQUIRE(ids[t][i] == ids[0][i]);
+        }
+    }
+}
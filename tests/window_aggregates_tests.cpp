@@ -0,0 +1,86 @@
+#include <window_aggregates.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("Empty window") {
+    RollingWindow<4> window;
+    REQUIRE(window.Count() == 0);
+    REQUIRE(window.Mean() == 0);
+    REQUIRE(window.Rate() == 0);
+}
+
+TEST_CASE("Window keeps the last values") {
+    RollingWindow<3> window;
+    window.Add(1'000'000'000, 5);
+    window.Add(2'000'000'000, 1);
+    window.Add(3'000'000'000, 3);
+    REQUIRE(window.Count() == 3);
+    REQUIRE(window.Mean() == 3);
+    REQUIRE(window.Min() == 1);
+    REQUIRE(window.Max() == 5);
+    REQUIRE(window.Rate() == -1);
+
+    // 5 leaves the window
+    window.Add(4'000'000'000, 2);
+    REQUIRE(window.Count() == 3);
+    REQUIRE(window.Mean() == 2);
+    REQUIRE(window.Min() == 1);
+    REQUIRE(window.Max() == 3);
+    REQUIRE(window.Rate() == 0.5);
+
+    // 1 leaves the window
+    window.Add(5'000'000'000, 4);
+    REQUIRE(window.Min() == 2);
+    REQUIRE(window.Max() == 4);
+}
+
+TEST_CASE("Window drops values older than duration") {
+    RollingWindow<16> window(std::chrono::nanoseconds{100});
+    window.Add(0, 10);
+    window.Add(50, 20);
+    window.Add(150, 30);
+    REQUIRE(window.Count() == 2);
+    REQUIRE(window.Min() == 20);
+    window.Add(1000, 1);
+    REQUIRE(window.Count() == 1);
+    REQUIRE(window.Max() == 1);
+}
+
+TEST_CASE("Value with timestamp older than the window is kept") {
+    RollingWindow<16> window(std::chrono::nanoseconds{100});
+    window.Add(1000, 10);
+    window.Add(1050, 20);
+    // Timestamp goes back
+    window.Add(500, 5);
+    REQUIRE(window.Count() == 3);
+    REQUIRE(window.Sum() == 35);
+    REQUIRE(window.Min() == 5);
+    REQUIRE(window.Max() == 20);
+    REQUIRE(window.Rate() == 0);
+
+    window.Add(1200, 7);
+    REQUIRE(window.Count() == 1);
+    REQUIRE(window.Min() == 7);
+    REQUIRE(window.Max() == 7);
+}
+
+TEST_CASE("Windows of several producers") {
+    MessageHistory history0, history1, history2;
+    ProducerWindows<8> windows({&history0, &history1, &history2});
+    REQUIRE(windows.Update() == 0);
+    REQUIRE(windows.Summary().count == 0);
+
+    history0.WriterAppend(0, Message{1});
+    history0.WriterAppend(1'000'000'000, Message{3});
+    history1.WriterAppend(0, Message{10});
+    history2.WriterAppend(0, Message{2});
+    REQUIRE(windows.Update() == 4);
+    REQUIRE(windows.Window(0).Mean() == 2);
+
+    WindowSummary summary = windows.Summary();
+    REQUIRE(summary.count == 4);
+    REQUIRE(summary.mean == 4);
+    REQUIRE(summary.min == 1);
+    REQUIRE(summary.max == 10);
+    REQUIRE(summary.rate == 2);
+}